@@ -0,0 +1,146 @@
+// Heap allocations per request of a handler in the style of /test: every query parameter is
+// copied into a key/value map and a JSON-ish body is built from it. Once with std::string and
+// std::map on the global heap, once with their std::pmr counterparts on request.memoryResource().
+//
+// Global operator new is replaced to count heap allocations, and blocks the arena itself takes
+// from malloc are added from its totals. The request is reset between iterations the way the
+// session rewinds its arena once a request is answered.
+//
+// Usage: ArenaBench [iterations, default 200000]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory_resource>
+#include <new>
+#include <string>
+
+#include "Request/HttpRequest.h"
+#include "Utils/BumpArena.h"
+
+namespace {
+u64 g_heapAllocations = 0;
+}
+
+void* operator new(std::size_t size)
+{
+    g_heapAllocations++;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr std::string_view PATH = "/test";
+constexpr std::string_view QUERY =
+    "user=alice.cooper%40example.com&session=ab12cd34ef56gh78ij90kl12&filter=created%3E2024-01-01"
+    "&sort=-updated_at&fields=id,name,email,created_at,updated_at&page=12&locale=en-US";
+
+template <typename String, typename Map>
+usize buildResponse(const HttpRequest& request, Map& result, String& body)
+{
+    for (usize i = 0; i < request.queryParamCount(); ++i)
+        result.emplace(String(request.queryKey(i), result.get_allocator()),
+                       String(request.queryValue(i), result.get_allocator()));
+
+    body += "{\n";
+    for (const auto& [key, value] : result)
+    {
+        body += "    \"";
+        body += key;
+        body += "\": \"";
+        body += value;
+        body += "\",\n";
+    }
+    body += "}";
+    return body.size();
+}
+
+usize heapHandler(const HttpRequest& request)
+{
+    std::map<std::string, std::string> result;
+    std::string body;
+    return buildResponse(request, result, body);
+}
+
+usize arenaHandler(const HttpRequest& request)
+{
+    std::pmr::memory_resource* mr = request.memoryResource();
+    std::pmr::map<std::pmr::string, std::pmr::string> result(mr);
+    std::pmr::string body(mr);
+    return buildResponse(request, result, body);
+}
+
+// Both handlers must build the same body, or the comparison is meaningless
+bool sameBody()
+{
+    BumpArena arena(REQUEST_ARENA_BLOCK_SIZE);
+    HttpRequest request(arena);
+    request.reset();
+    request.setPath(PATH, QUERY);
+
+    std::map<std::string, std::string> heapResult;
+    std::string heapBody;
+    buildResponse(request, heapResult, heapBody);
+
+    std::pmr::map<std::pmr::string, std::pmr::string> arenaResult(request.memoryResource());
+    std::pmr::string arenaBody(request.memoryResource());
+    buildResponse(request, arenaResult, arenaBody);
+
+    return heapResult.size() == request.queryParamCount() && std::string_view(heapBody) == std::string_view(arenaBody);
+}
+
+template <typename Handler>
+void run(const char* name, int iterations, Handler handler)
+{
+    BumpArena::Totals totals;
+    BumpArena arena(REQUEST_ARENA_BLOCK_SIZE, &totals);
+    HttpRequest request(arena);
+
+    u64 heapBefore = g_heapAllocations;
+    usize bytes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        request.reset();
+        request.setPath(PATH, QUERY);
+        bytes += handler(request);
+
+        // Answered: what the session does in releaseRequestMemory()
+        request.dropQueryCache();
+        arena.reset();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    u64 heap = g_heapAllocations - heapBefore + totals.heapBlocks;
+    std::printf("%-6s %10.2f heap allocs/request %10.2f arena allocs/request %8.1f ns/request (%zu body bytes)\n",
+                name, static_cast<double>(heap) / iterations,
+                static_cast<double>(totals.allocations) / iterations,
+                std::chrono::duration<double, std::nano>(elapsed).count() / iterations,
+                bytes / iterations);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+    if (iterations < 1)
+        iterations = 1;
+
+    if (!sameBody())
+    {
+        std::fprintf(stderr, "heap and arena handlers built different bodies\n");
+        return 1;
+    }
+
+    run("heap", iterations, heapHandler);
+    run("arena", iterations, arenaHandler);
+    return 0;
+}
@@ -0,0 +1,225 @@
+// Loopback load generator for before/after runs of server settings, e.g. multishot_recv.
+//
+// Opens keep-alive connections to a running WarpApi and keeps a fixed number of pipelined
+// GETs in flight on each. Reports throughput and latency percentiles, measured from the
+// moment a request is written to the moment its whole response has been read. Single
+// threaded and epoll driven, pin it away from the server's workers (taskset) so they do
+// not compete for a core.
+//
+// Usage: LoopbackBench [port 8080] [connections 64] [pipeline depth 16] [seconds 10] [path /version]
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "WarpDefs.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Connection {
+    int fd = -1;
+    std::string out;
+    usize outSent = 0;
+    std::string in;
+    // Send time of every request still waiting for its response, oldest first
+    std::deque<Clock::time_point> inFlight;
+};
+
+// Length of the first complete response in @p in, 0 if it is not complete yet
+usize completeResponse(std::string_view in)
+{
+    usize headEnd = in.find("\r\n\r\n");
+    if (headEnd == std::string_view::npos)
+        return 0;
+
+    usize length = 0;
+    std::string_view head = in.substr(0, headEnd);
+    usize cl = head.find("Content-Length: ");
+    if (cl != std::string_view::npos)
+        length = std::strtoull(head.data() + cl + 16, nullptr, 10);
+
+    usize total = headEnd + 4 + length;
+    return in.size() >= total ? total : 0;
+}
+
+bool flush(Connection& conn)
+{
+    while (conn.outSent < conn.out.size())
+    {
+        ssize_t n = send(conn.fd, conn.out.data() + conn.outSent, conn.out.size() - conn.outSent, MSG_NOSIGNAL);
+        if (n < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        conn.outSent += n;
+    }
+    conn.out.clear();
+    conn.outSent = 0;
+    return true;
+}
+
+void queueRequests(Connection& conn, const std::string& request, usize count)
+{
+    Clock::time_point now = Clock::now();
+    for (usize i = 0; i < count; ++i)
+    {
+        conn.out += request;
+        conn.inFlight.push_back(now);
+    }
+}
+
+double percentile(std::vector<u32>& samples, double p)
+{
+    if (samples.empty())
+        return 0;
+    usize idx = std::min(samples.size() - 1, static_cast<usize>(p * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+    return samples[idx];
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int port = argc > 1 ? std::atoi(argv[1]) : 8080;
+    usize connections = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+    usize depth = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 16;
+    int seconds = argc > 4 ? std::atoi(argv[4]) : 10;
+    std::string path = argc > 5 ? argv[5] : "/version";
+
+    if (connections == 0 || depth == 0 || seconds <= 0)
+    {
+        std::fprintf(stderr, "connections, depth and seconds must be positive\n");
+        return 1;
+    }
+
+    const std::string request = "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: keep-alive\r\n\r\n";
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<u16>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    std::vector<Connection> conns(connections);
+
+    for (usize i = 0; i < connections; ++i)
+    {
+        Connection& conn = conns[i];
+        conn.fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (conn.fd < 0 || connect(conn.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0)
+        {
+            std::perror("connect");
+            return 1;
+        }
+
+        int one = 1;
+        setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fcntl(conn.fd, F_SETFL, fcntl(conn.fd, F_GETFL) | O_NONBLOCK);
+
+        epoll_event ev = {};
+        ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        ev.data.u64 = i;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, conn.fd, &ev);
+
+        queueRequests(conn, request, depth);
+        flush(conn);
+    }
+
+    std::vector<u32> latenciesUs;
+    latenciesUs.reserve(1 << 20);
+    u64 responses = 0;
+    u64 errors = 0;
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point stop = start + std::chrono::seconds(seconds);
+    std::vector<epoll_event> events(connections);
+    char buf[64 * 1024];
+
+    while (Clock::now() < stop)
+    {
+        int n = epoll_wait(epfd, events.data(), static_cast<int>(events.size()), 100);
+        for (int e = 0; e < n; ++e)
+        {
+            Connection& conn = conns[events[e].data.u64];
+            if (conn.fd < 0)
+                continue;
+
+            if (events[e].events & EPOLLIN)
+            {
+                while (true)
+                {
+                    ssize_t r = recv(conn.fd, buf, sizeof(buf), 0);
+                    if (r > 0)
+                    {
+                        conn.in.append(buf, r);
+                        continue;
+                    }
+                    if (r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+                    {
+                        errors++;
+                        ::close(conn.fd);
+                        conn.fd = -1;
+                    }
+                    break;
+                }
+                if (conn.fd < 0)
+                    continue;
+
+                Clock::time_point now = Clock::now();
+                usize consumed = 0;
+                usize done = 0;
+                while (usize len = completeResponse(std::string_view(conn.in).substr(consumed)))
+                {
+                    if (conn.in.compare(consumed, 12, "HTTP/1.1 200") != 0)
+                        errors++;
+
+                    auto us = std::chrono::duration_cast<std::chrono::microseconds>(now - conn.inFlight.front());
+                    latenciesUs.push_back(static_cast<u32>(us.count()));
+                    conn.inFlight.pop_front();
+                    consumed += len;
+                    done++;
+                }
+                conn.in.erase(0, consumed);
+                responses += done;
+
+                // Refill the pipeline with as many requests as were answered
+                queueRequests(conn, request, done);
+            }
+
+            if (!flush(conn))
+            {
+                errors++;
+                ::close(conn.fd);
+                conn.fd = -1;
+            }
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("%zu connections, depth %zu, %s for %.1f s\n", connections, depth, path.c_str(), elapsed);
+    std::printf("requests/s: %.0f, errors: %llu\n", responses / elapsed, static_cast<unsigned long long>(errors));
+    std::printf("latency us: p50 %.0f, p99 %.0f, p99.9 %.0f\n",
+                percentile(latenciesUs, 0.50), percentile(latenciesUs, 0.99), percentile(latenciesUs, 0.999));
+
+    for (Connection& conn : conns)
+        if (conn.fd >= 0)
+            ::close(conn.fd);
+    ::close(epfd);
+    return errors == 0 ? 0 : 1;
+}
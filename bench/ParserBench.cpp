@@ -0,0 +1,126 @@
+// Request parsing cost when a large request trickles in.
+//
+// A 16 KB GET (browser-like headers plus large cookie/trace headers) is written to one end
+// of a socketpair in fixed-size pieces, and an epoll Session on the other end gets a read
+// turn after every piece, as the event loop would after each EPOLLIN. Unknown routes are
+// answered with 404, which is drained after each request.
+//
+// Usage: ParserBench [requests scale, default 1]
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <ink/ink.hpp>
+
+#include "EventLoop/WorkerContext.h"
+#include "Server/Session.h"
+#include "Settings/Settings.h"
+
+namespace {
+
+constexpr usize REQUEST_SIZE = 16 * 1024;
+
+std::string makeRequest()
+{
+    std::string req =
+        "GET /bench/missing?page=2&sort=desc HTTP/1.1\r\n"
+        "Host: api.example.com\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/124.0.0.0 Safari/537.36\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+        "Accept-Language: en-US,en;q=0.9\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Connection: keep-alive\r\n";
+
+    // Large cookie and tracing headers make up the rest, as behind SSO and proxies
+    for (int i = 0; req.size() + 64 < REQUEST_SIZE; ++i)
+    {
+        std::string name = "X-Trace-" + std::to_string(i) + ": ";
+        usize room = REQUEST_SIZE - req.size() - name.size() - 4;
+        req += name + std::string(std::min<usize>(room, 700), 'a' + i % 26) + "\r\n";
+    }
+    req += "\r\n";
+    return req;
+}
+
+bool drainResponse(int fd)
+{
+    // The 404 is small and sent in one piece once the request is complete
+    char buf[4096];
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    return n > 0 && std::string_view(buf, n).find("\r\n\r\n") != std::string_view::npos;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int scale = argc > 1 ? std::atoi(argv[1]) : 1;
+    if (scale < 1)
+        scale = 1;
+
+    if (!Settings::updateSettings(ink::EnhancedJson()))
+    {
+        std::fprintf(stderr, "Default settings rejected\n");
+        return 1;
+    }
+
+    WorkerContext worker;
+    worker.backend = IoBackend::Epoll;
+    worker.epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+    const std::string request = makeRequest();
+    std::printf("request: %zu bytes\n", request.size());
+
+    struct Run { usize piece; int requests; };
+    const Run runs[] = { {1, 20}, {100, 500}, {1448, 2000} };
+
+    for (const Run& run : runs)
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) != 0)
+        {
+            std::perror("socketpair");
+            return 1;
+        }
+
+        Session session(fds[0], &worker);
+        int requests = run.requests * scale;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < requests; ++r)
+        {
+            for (usize off = 0; off < request.size(); off += run.piece)
+            {
+                usize len = std::min(run.piece, request.size() - off);
+                if (send(fds[1], request.data() + off, len, 0) != static_cast<ssize_t>(len))
+                {
+                    std::perror("send");
+                    return 1;
+                }
+                session.onReadReady();
+            }
+
+            if (!drainResponse(fds[1]))
+            {
+                std::fprintf(stderr, "no response to request %d (piece %zu)\n", r, run.piece);
+                return 1;
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        double us = std::chrono::duration<double, std::micro>(elapsed).count() / requests;
+        std::printf("piece %5zu B: %10.1f us/request, %8.1f MB/s (%d requests)\n",
+                    run.piece, us, request.size() / us, requests);
+
+        ::close(fds[1]);
+    }
+
+    ::close(worker.epollFd);
+    return 0;
+}
@@ -23,6 +23,55 @@ public:
         _handlerCallBack = handlerCallback;
     }
 
+    /** @brief Switches the endpoint to BodyMode::Stream, @p chunkCallback sees the body before the handler runs. */
+    void setBodyChunkCallback(BodyChunkHandler chunkCallback)
+    {
+        _bodyChunkCallBack = chunkCallback;
+        _bodyMode = BodyMode::Stream;
+    }
+
+    void setBodyMode(BodyMode mode)
+    {
+        _bodyMode = mode;
+    }
+
+    BodyMode getBodyMode() const
+    {
+        return _bodyMode;
+    }
+
+    /** @brief Per-route body limit, 0 keeps max_body_size (or max_upload_size when not buffered). */
+    void setMaxBodySize(usize maxBodySize)
+    {
+        _maxBodySize = maxBodySize;
+    }
+
+    usize getMaxBodySize() const
+    {
+        return _maxBodySize;
+    }
+
+    /**
+     * @brief Caches the handler's 200 responses for @p ttlMs, per worker, up to @p budget bytes.
+     * Only for responses that depend on nothing but the path and the query.
+     */
+    void setResponseCache(u32 ttlMs, usize budget)
+    {
+        _cacheTtlMs = ttlMs;
+        _cacheBudget = budget;
+    }
+
+    /** @brief 0 when responses are not cached. */
+    u32 getCacheTtl() const
+    {
+        return _cacheTtlMs;
+    }
+
+    usize getCacheBudget() const
+    {
+        return _cacheBudget;
+    }
+
     const Method& getMethod() const
     {
         return _method;
@@ -38,11 +87,21 @@ public:
         _handlerCallBack(req, responseManager);
     }
 
+    bool execBodyChunk(const HttpRequest& req, std::string_view chunk)
+    {
+        return _bodyChunkCallBack(req, chunk);
+    }
+
 protected:
     std::string _route;
     Method _method;
 
     RequestHandler _handlerCallBack;
+    BodyChunkHandler _bodyChunkCallBack;
+    BodyMode _bodyMode = BodyMode::Buffered;
+    usize _maxBodySize = 0;
+    u32 _cacheTtlMs = 0;
+    usize _cacheBudget = 0;
 };
 
 
@@ -0,0 +1,301 @@
+#include "EventLoop.h"
+
+#include <ink/TimerWheel.h>
+#include <algorithm>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+
+#include "Server/Session.h"
+#include "Settings/Settings.h"
+#include "WorkerContext.h"
+
+// Per-epoll busy poll parameters (Linux 6.9), missing from older libc headers
+#ifndef EPIOCSPARAMS
+struct epoll_params {
+    u32 busy_poll_usecs;
+    u16 busy_poll_budget;
+    u8 prefer_busy_poll;
+    u8 __pad;
+};
+#define EPOLL_IOC_TYPE 0x8A
+#define EPIOCSPARAMS _IOW(EPOLL_IOC_TYPE, 0x01, struct epoll_params)
+#endif
+
+void EventLoop::runEpollWorker(WorkerContext& worker, socket_t listenFd)
+{
+    auto& settings = Settings::getSettings();
+
+    // TimerWheel that marks n seconds until session expires
+    // handling keep alives sessions
+    ink::TimerWheel timerWheel(settings.connection_timeout_ms/1000, TIMERWHELL_TICK_INTERVAL);
+
+    // ObjectPool to reduce session allocation
+    auto sessionPool = std::make_unique<ObjectPool<Session, SESSION_POOL_SIZE>>();
+
+    // Using one session table per thread
+    // Using Vector for O(1) access instead of Map
+    std::vector<Session*> sessionTable;
+    sessionTable.resize(MAX_EVENTS);
+
+    // Create Epoll for this thread
+    int epfd = epoll_create1(0);
+    worker.epollFd = epfd;
+
+    // Let epoll_wait itself busy poll the NAPI contexts of its sockets
+    const u64 busyPollUs = settings.busy_poll_us;
+    if (busyPollUs > 0)
+    {
+        epoll_params params = {};
+        params.busy_poll_usecs = settings.busy_poll_us;
+        params.busy_poll_budget = settings.busy_poll_budget;
+        params.prefer_busy_poll = 1;
+
+        if (ioctl(epfd, EPIOCSPARAMS, &params) < 0)
+            INK_WARN << "Thread " << worker.threadIdx << " epoll busy poll parameters unavailable: " << strerror(errno);
+    }
+
+    // Add Listener to Epoll (none in AcceptMode::Central)
+    struct epoll_event ev;
+    if (listenFd != SOCKET_ERROR_VALUE)
+    {
+        ev.data.fd = listenFd;
+        ev.events = EPOLLIN | EPOLLET;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, listenFd, &ev);
+    }
+
+    // Bumped by other threads after queueing work for this worker
+    worker.wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    ev.data.fd = worker.wakeFd;
+    ev.events = EPOLLIN | EPOLLET;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, worker.wakeFd, &ev);
+    worker.mailbox.attachEventFd(worker.wakeFd);
+
+    // Sessions whose read turn ran out of budget with input left: the ones queued during an
+    // iteration each get one more turn at its end (readyRound), round-robin, before epoll_wait
+    std::vector<Session*> readyList;
+    std::vector<Session*> readyRound;
+
+    auto releaseSession = [&](Session* s) {
+        if (!s) return;
+
+        // Rare, only sessions dying between two turns pay the scan
+        if (s->readyQueued)
+        {
+            std::replace(readyList.begin(), readyList.end(), s, static_cast<Session*>(nullptr));
+            std::replace(readyRound.begin(), readyRound.end(), s, static_cast<Session*>(nullptr));
+        }
+
+        worker.activeSessions.fetch_sub(1, std::memory_order_relaxed);
+        timerWheel.unlink(s);
+        int fd = s->getSocket();
+        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+        s->~Session();
+        sessionPool->release(s);
+
+        if (fd < sessionTable.size())
+            sessionTable[fd] = nullptr;
+    };
+
+    // Registers a connected socket, accepted here or handed off by the central acceptor
+    auto adoptConnection = [&](socket_t clientSock) {
+        Session* session = sessionPool->acquire();
+        new (session) Session(clientSock, &worker);
+        worker.stats.recordAccept(session->incomingCpu(), worker.cpu);
+
+        if (clientSock >= (int)sessionTable.size())
+        {
+            sessionTable.resize(clientSock * 2);
+        }
+
+        sessionTable[clientSock] = session;
+
+        epoll_event cev{};
+        cev.data.fd = clientSock;
+        cev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, clientSock, &cev);
+    };
+
+    std::vector<struct epoll_event> events(MAX_EVENTS);
+
+    auto readTurn = [&](Session* session) -> bool {
+        session->readyQueued = false;
+        bool activity = session->onReadReady();
+
+        if (session->hasPendingInput())
+        {
+            session->readyQueued = true;
+            readyList.push_back(session);
+            worker.stats.budgetYields++;
+        }
+        return activity;
+    };
+
+    auto touchSession = [&](Session* session, u64 now) {
+        if (now - session->lastActivityTick >= TIMERWHELL_TICK_INTERVAL)
+        {
+            timerWheel.update(session);
+            session->lastActivityTick = now;
+        }
+    };
+
+    worker.ready.store(true, std::memory_order_release);
+
+    // Set when the last mailbox drain hit its batch limit
+    bool mailboxBacklog = false;
+
+    while (_running)
+    {
+        u64 currentLoopTime = ink::utils::nowMillis();
+        int timeout = (mailboxBacklog || !readyList.empty()) ? 0 : timerWheel.timeToNextTickMillis(currentLoopTime);
+
+        // Served after this iteration's events, sessions yielding meanwhile wait for the next one
+        readyRound.swap(readyList);
+
+        // Busy poll: burn up to busy_poll_us on non-blocking waits before sleeping
+        int nfds = 0;
+        if (busyPollUs > 0 && timeout != 0)
+        {
+            u64 spinStart = monotonicMicros();
+            u64 now = spinStart;
+            do {
+                nfds = epoll_wait(epfd, events.data(), MAX_EVENTS, 0);
+                now = monotonicMicros();
+            } while (nfds == 0 && now - spinStart < busyPollUs);
+            worker.stats.spinUs += now - spinStart;
+        }
+
+        if (nfds > 0)
+        {
+            worker.stats.spinHits++;
+        }
+        else if (timeout == 0)
+        {
+            nfds = epoll_wait(epfd, events.data(), MAX_EVENTS, 0);
+        }
+        else
+        {
+            // INK_DEBUG << "[Loop] Calling epoll_wait with timeout: " << timeout << "ms";
+            u64 waitStart = monotonicMicros();
+            nfds = epoll_wait(epfd, events.data(), MAX_EVENTS, timeout);
+            worker.stats.blockedUs += monotonicMicros() - waitStart;
+            worker.stats.wakeups++;
+            // INK_DEBUG << "[Loop] epoll_wait returned " << nfds << " events.";
+        }
+
+        for (int i = 0; i < nfds; ++i)
+        {
+            socket_t fd = events[i].data.fd;
+            uint32_t evs = events[i].events;
+
+            if (fd == worker.wakeFd)
+            {
+                // Reset the counter before draining, a push racing with this still re-arms the fd.
+                // Mailbox tasks sharing this fd are drained at the end of the iteration
+                u64 wakeups;
+                if (read(worker.wakeFd, &wakeups, sizeof(wakeups)) < 0 && errno != EAGAIN)
+                    INK_WARN << "Thread " << worker.threadIdx << " eventfd read failed: " << strerror(errno);
+
+                socket_t clientSock;
+                while (worker.handoffQueue.pop(clientSock))
+                    adoptConnection(clientSock);
+                continue;
+            }
+
+            if (fd == listenFd)
+            {
+                while (true)
+                {
+                    int clientSock = accept4(
+                        listenFd, nullptr, nullptr,
+                        SOCK_NONBLOCK | SOCK_CLOEXEC
+                        );
+
+                    if (clientSock < 0)
+                    {
+                        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                            // INK_DEBUG << "[Listener] EAGAIN reached. Done accepting.";
+                            break;
+                        }
+                        continue;
+                    }
+
+                    worker.activeSessions.fetch_add(1, std::memory_order_relaxed);
+                    adoptConnection(clientSock);
+                }
+                continue;
+            }
+
+            Session* session = sessionTable[fd];
+
+            bool activity = false;
+
+            // Read, unless the session already waits in this round for its next turn
+            if ((evs & (EPOLLIN | EPOLLRDHUP)) && !session->readyQueued)
+            {
+                activity |= readTurn(session);
+            }
+
+            // Write
+            if (session->getSocket() != SOCKET_ERROR_VALUE && (evs & EPOLLOUT))
+            {
+                activity |= session->onWriteReady();
+
+                // A streamed response that just ended held back the reads
+                if (session->hasPendingInput() && !session->readyQueued)
+                {
+                    session->readyQueued = true;
+                    readyList.push_back(session);
+                }
+            }
+
+            // Error / Hangup
+            if (evs & (EPOLLERR | EPOLLHUP))
+            {
+                releaseSession(session);
+                continue;
+            }
+
+            if (activity)
+                touchSession(session, currentLoopTime);
+        }
+
+        for (Session* session : readyRound)
+        {
+            // Released since it was queued
+            if (!session)
+                continue;
+
+            if (session->getSocket() == SOCKET_ERROR_VALUE)
+            {
+                session->readyQueued = false;
+                continue;
+            }
+
+            if (readTurn(session))
+                touchSession(session, currentLoopTime);
+        }
+        readyRound.clear();
+
+        while (timerWheel.timeToNextTickMillis(currentLoopTime) == 0)
+        {
+            timerWheel.processExpired([&](ink::TimerNode* n) {
+                Session* s = static_cast<Session*>(n);
+                releaseSession(s);
+            });
+
+            worker.responseHeads.refreshDate(time(nullptr));
+        }
+
+        mailboxBacklog = worker.mailbox.drain(worker, MAILBOX_DRAIN_BATCH);
+    }
+
+    worker.ready.store(false, std::memory_order_release);
+
+    // Connections handed off after the last wakeup never got a session
+    socket_t orphan;
+    while (worker.handoffQueue.pop(orphan))
+        close(orphan);
+
+    close(worker.wakeFd);
+    close(epfd);
+}
@@ -1,14 +1,13 @@
 #include "EventLoop.h"
 
-#include <ink/TimerWheel.h>
+#include <linux/filter.h>
+#include <poll.h>
 
-#include "Server/Session.h"
+#include "Endpoint/Endpoint.h"
 #include "Settings/Settings.h"
+#include "WorkerContext.h"
 
-#ifdef USE_IOURING
-static inline char listener_marker;
-#define LISTENER_TAG ((u64)&listener_marker)
-#endif
+static thread_local WorkerContext* tl_currentWorker = nullptr;
 
 EventLoop::EventLoop() :
     _running(false)
@@ -27,17 +26,89 @@ void EventLoop::start()
 
     uint max_threads = Settings::getSettings().max_threads;
 
-    // Spawn Worker Threads
+    _backend = resolveBackend();
+
+    if (_backend == IoBackend::IoUring && Settings::getSettings().ring_mode == RingSetupMode::SharedSqPoll)
+    {
+        io_uring_params params = {};
+        params.flags = IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = TIMERWHELL_TICK_INTERVAL;
+
+        int ret = io_uring_queue_init_params(8, &_sqPollRing, &params);
+        if (ret < 0)
+            INK_ERROR << "Shared SQPOLL ring init failed: " << strerror(-ret);
+        else
+            _hasSqPollRing = true;
+    }
+
+    const bool centralAccept = Settings::getSettings().accept_mode == AcceptMode::Central;
+
+    // Listeners are created up front and in order so the reuseport group index matches the worker index
+    std::vector<socket_t> listeners;
+    for (u32 i = 0; i < (centralAccept ? 1 : max_threads); i++)
+        listeners.push_back(createListener(i));
+
+    if (!centralAccept && Settings::getSettings().cpu_steering)
+    {
+        if (!attachCpuSteering(listeners))
+            INK_WARN << "SO_ATTACH_REUSEPORT_CBPF failed, using hashed reuseport: " << strerror(errno);
+    }
+
+    // Every worker exists before the first thread runs: post() and pickWorker() walk _workers
+    std::vector<socket_t> workerListeners;
     for (u32 i = 0; i < max_threads; i++) {
-        _threads.emplace_back(&EventLoop::runWorker, this, i);
+        socket_t listenFd = centralAccept ? SOCKET_ERROR_VALUE : listeners[i];
+        if (!centralAccept && listenFd == SOCKET_ERROR_VALUE)
+            continue;
+
+        auto worker = std::make_unique<WorkerContext>();
+        worker->loop = this;
+        worker->threadIdx = i;
+        worker->backend = _backend;
+        worker->cpu = i % std::thread::hardware_concurrency();
+
+        _workers.push_back(std::move(worker));
+        workerListeners.push_back(listenFd);
+    }
+
+    // Spawn Worker Threads
+    for (usize w = 0; w < _workers.size(); w++) {
+        WorkerContext* worker = _workers[w].get();
+        _threads.emplace_back(&EventLoop::runWorker, this, worker, workerListeners[w]);
 
         cpu_set_t cpuset;
         CPU_ZERO(&cpuset);
-        CPU_SET(i % std::thread::hardware_concurrency(), &cpuset);
+        CPU_SET(worker->cpu, &cpuset);
         pthread_setaffinity_np(_threads.back().native_handle(), sizeof(cpu_set_t), &cpuset);
     }
 
-    INK_INFO << "EventLoop started with " << max_threads << " independent listeners.";
+    if (centralAccept && listeners[0] != SOCKET_ERROR_VALUE)
+    {
+        // The acceptor only hands connections to ready workers, anything accepted before then would be dropped
+        for (auto& worker : _workers)
+        {
+            while (!worker->ready.load(std::memory_order_acquire) && !worker->exited.load(std::memory_order_acquire))
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        _threads.emplace_back(&EventLoop::runAcceptor, this, listeners[0]);
+    }
+
+    INK_INFO << "EventLoop started with " << max_threads << (centralAccept ? " workers behind a central acceptor on " : " independent listeners on ")
+             << (_backend == IoBackend::IoUring ? "io_uring" : "epoll") << ".";
+}
+
+IoBackend EventLoop::resolveBackend()
+{
+    IoBackend configured = Settings::getSettings().backend;
+    if (configured != IoBackend::Auto)
+        return configured;
+
+    std::string reason;
+    if (probeIoUring(reason))
+        return IoBackend::IoUring;
+
+    INK_WARN << "io_uring unavailable (" << reason << "), falling back to epoll.";
+    return IoBackend::Epoll;
 }
 
 void EventLoop::stop()
@@ -49,16 +120,24 @@ void EventLoop::stop()
         if (t.joinable()) t.join();
     }
     _threads.clear();
+    _workers.clear();
+
+    if (_hasSqPollRing)
+    {
+        io_uring_queue_exit(&_sqPollRing);
+        _hasSqPollRing = false;
+    }
+
     INK_DEBUG << "EventLoop stopped";
 }
 
-void EventLoop::runWorker(i32 threadIdx)
+socket_t EventLoop::createListener(i32 threadIdx)
 {
     int listenFd = socket(AF_INET, SOCK_STREAM, 0);
     if (listenFd < 0)
     {
         INK_ERROR << "Thread " << threadIdx << " failed to create socket";
-        return;
+        return SOCKET_ERROR_VALUE;
     }
 
     int opt = 1;
@@ -73,6 +152,21 @@ void EventLoop::runWorker(i32 threadIdx)
 
     auto& settings = Settings::getSettings();
 
+    // Copied onto every socket accepted from this listener, direct descriptors included
+    if (settings.busy_poll_us > 0)
+    {
+        int usecs = static_cast<int>(settings.busy_poll_us);
+        int budget = settings.busy_poll_budget;
+
+        // Raising these above net.core.busy_read / the default budget needs CAP_NET_ADMIN
+        if (setsockopt(listenFd, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs)) < 0 ||
+            setsockopt(listenFd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &opt, sizeof(opt)) < 0 ||
+            setsockopt(listenFd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &budget, sizeof(budget)) < 0)
+        {
+            INK_WARN << "Thread " << threadIdx << " socket busy polling unavailable: " << strerror(errno);
+        }
+    }
+
     sockaddr_in addr{};
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = INADDR_ANY;
@@ -82,353 +176,265 @@ void EventLoop::runWorker(i32 threadIdx)
     {
         INK_ERROR << "Thread " << threadIdx << " bind failed: " << strerror(errno);
         close(listenFd);
-        return;
+        return SOCKET_ERROR_VALUE;
     }
 
     if (listen(listenFd, settings.backlog_size) < 0)
     {
         INK_ERROR << "Thread " << threadIdx << " listen failed";
         close(listenFd);
-        return;
+        return SOCKET_ERROR_VALUE;
     }
 
-    // TimerWheel that marks n seconds until session expires
-    // handling keep alives sessions
-    ink::TimerWheel timerWheel(settings.connection_timeout_ms/1000, TIMERWHELL_TICK_INTERVAL);
-
-    // ObjectPool to reduce session allocation
-    auto sessionPool = std::make_unique<ObjectPool<Session, SESSION_POOL_SIZE>>();
-
-#ifdef USE_EPOLL
-    // Using one session table per thread
-    // Using Vector for O(1) access instead of Map
-    std::vector<Session*> sessionTable;
-    sessionTable.resize(MAX_EVENTS);
-
-    // Create Epoll for this thread
-    int epfd = epoll_create1(0);
+    return listenFd;
+}
 
-    // Add Listener to Epoll
-    struct epoll_event ev;
-    ev.data.fd = listenFd;
-    ev.events = EPOLLIN | EPOLLET;
-    epoll_ctl(epfd, EPOLL_CTL_ADD, listenFd, &ev);
+bool EventLoop::attachCpuSteering(const std::vector<socket_t>& listeners)
+{
+    // Only listeners that opened joined the reuseport group, in worker order: worker i is
+    // pinned to the same core as in start() and its listener sits at the count of open ones before it
+    u32 hwThreads = std::thread::hardware_concurrency();
+    std::vector<sock_filter> code;
+    code.push_back({ BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<u32>(SKF_AD_OFF + SKF_AD_CPU) });  // A = CPU handling the SYN
+
+    socket_t groupFd = SOCKET_ERROR_VALUE;
+    u32 groupSize = 0;
+    for (u32 i = 0; i < listeners.size(); ++i)
+    {
+        if (listeners[i] == SOCKET_ERROR_VALUE)
+            continue;
+        if (groupFd == SOCKET_ERROR_VALUE)
+            groupFd = listeners[i];
 
-    auto releaseSession = [&](Session* s) {
-        if (!s) return;
+        code.push_back({ BPF_JMP | BPF_JEQ | BPF_K, 0, 1, i % hwThreads });  // A == worker's core?
+        code.push_back({ BPF_RET | BPF_K,           0, 0, groupSize++ });     // its listener
+    }
 
-        timerWheel.unlink(s);
-        int fd = s->getSocket();
-        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
-        s->~Session();
-        sessionPool->release(s);
+    if (groupFd == SOCKET_ERROR_VALUE)
+    {
+        errno = EBADF;
+        return false;
+    }
 
-        if (fd < sessionTable.size())
-            sessionTable[fd] = nullptr;
-    };
+    // Cores without a worker of their own are spread over the group
+    code.push_back({ BPF_ALU | BPF_MOD | BPF_K, 0, 0, groupSize });  // A %= listeners
+    code.push_back({ BPF_RET | BPF_A,           0, 0, 0 });          // index into the group
 
-    std::vector<struct epoll_event> events(MAX_EVENTS);
+    sock_fprog prog = {};
+    prog.len = static_cast<u16>(code.size());
+    prog.filter = code.data();
 
-    while (_running)
-    {
-        u64 currentLoopTime = ink::utils::nowMillis();
-        int timeout = timerWheel.timeToNextTickMillis(currentLoopTime);
+    return setsockopt(groupFd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) == 0;
+}
 
-        // INK_DEBUG << "[Loop] Calling epoll_wait with timeout: " << timeout << "ms";
-        int nfds = epoll_wait(epfd, events.data(), MAX_EVENTS, timeout);
-        // INK_DEBUG << "[Loop] epoll_wait returned " << nfds << " events.";
+bool EventLoop::post(u32 workerIdx, WorkerTask task)
+{
+    if (workerIdx >= _workers.size())
+        return false;
 
-        for (int i = 0; i < nfds; ++i)
-        {
-            socket_t fd = events[i].data.fd;
-            uint32_t evs = events[i].events;
+    WorkerContext& target = *_workers[workerIdx];
+    if (!target.ready.load(std::memory_order_acquire))
+        return false;
 
-            if (fd == listenFd)
-            {
-                while (true)
-                {
-                    int clientSock = accept4(
-                        listenFd, nullptr, nullptr,
-                        SOCK_NONBLOCK | SOCK_CLOEXEC
-                        );
-
-                    if (clientSock < 0)
-                    {
-                        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-                            // INK_DEBUG << "[Listener] EAGAIN reached. Done accepting.";
-                            break;
-                        }
-                        continue;
-                    }
-
-                    Session* session = sessionPool->acquire();
-                    new (session) Session(clientSock, epfd);
-
-                    if (clientSock >= (int)sessionTable.size())
-                    {
-                        sessionTable.resize(clientSock * 2);
-                    }
-
-                    sessionTable[clientSock] = session;
-
-                    epoll_event ev{};
-                    ev.data.fd = clientSock;
-                    ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
-                    epoll_ctl(epfd, EPOLL_CTL_ADD, clientSock, &ev);
-                }
-                continue;
-            }
+    return target.mailbox.post(std::move(task));
+}
 
-            Session* session = sessionTable[fd];
+u32 EventLoop::broadcast(const WorkerTask& task)
+{
+    u32 delivered = 0;
+    for (u32 i = 0; i < _workers.size(); ++i)
+    {
+        if (post(i, task))
+            delivered++;
+    }
+    return delivered;
+}
 
-            bool activity = false;
+WorkerContext* EventLoop::currentWorker() noexcept
+{
+    return tl_currentWorker;
+}
 
-            // Read
-            if (evs & (EPOLLIN | EPOLLRDHUP))
-            {
-                activity |= session->onReadReady();
-            }
+void EventLoop::runWorker(WorkerContext* worker, socket_t listenFd)
+{
+    tl_currentWorker = worker;
+
+    worker->overflowBlocks.setLimit(Settings::getSettings().worker_response_overflow);
+
+    u64 startedUs = monotonicMicros();
+
+    if (_backend == IoBackend::IoUring)
+        runIoUringWorker(*worker, listenFd);
+    else
+        runEpollWorker(*worker, listenFd);
+
+    u64 runUs = std::max<u64>(monotonicMicros() - startedUs, 1);
+
+    const WorkerStats& stats = worker->stats;
+    INK_INFO << "Thread " << worker->threadIdx << " stats: sends " << stats.plainSends << " copied / "
+             << stats.zeroCopySends << " zero-copy, accepts " << stats.localCpuAccepts << " cpu-local / "
+             << stats.remoteCpuAccepts << " cross-cpu, mailbox tasks " << stats.mailboxTasks
+             << ", budget yields " << stats.budgetYields << ", overflow closes " << stats.overflowCloses
+             << " (peak overflow " << worker->overflowBlocks.peakInUse() << " bytes)";
+    INK_INFO << "Thread " << worker->threadIdx << " requests: " << stats.requests << ", arena allocations "
+             << worker->arenaTotals.allocations << " (" << (stats.requests ? worker->arenaTotals.allocations / stats.requests : 0)
+             << " per request), arena heap blocks " << worker->arenaTotals.heapBlocks;
+    worker->responseCache.forEachRoute([&](const Endpoint& endpoint, const ResponseCache::RouteStats& route) {
+        INK_INFO << "Thread " << worker->threadIdx << " cache " << endpoint.getRoute() << ": " << route.hits
+                 << " hits, " << route.misses << " misses, " << route.entries << " entries (" << route.bytes << " bytes)";
+    });
+    INK_INFO << "Thread " << worker->threadIdx << " waits: spun " << stats.spinUs << "us ("
+             << stats.spinHits << " hits), " << stats.wakeups << " wakeups, idle "
+             << (stats.blockedUs * 100 / runUs) << "%";
+
+    tl_currentWorker = nullptr;
+
+    if (listenFd != SOCKET_ERROR_VALUE)
+        close(listenFd);
 
-            // Write
-            if (session->getSocket() != SOCKET_ERROR_VALUE && (evs & EPOLLOUT))
-            {
-                activity |= session->onWriteReady();
-            }
+    worker->exited.store(true, std::memory_order_release);
+}
 
-            // Error / Hangup
-            if (evs & (EPOLLERR | EPOLLHUP))
-            {
-                releaseSession(session);
-                continue;
-            }
+i32 EventLoop::pickWorker(u32& cursor) const
+{
+    i32 best = -1;
+    u32 bestLoad = UINT32_MAX;
+    usize count = _workers.size();
 
-            if (activity)
-            {
-                if (currentLoopTime - session->lastActivityTick >= TIMERWHELL_TICK_INTERVAL)
-                {
-                    timerWheel.update(session);
-                    session->lastActivityTick = currentLoopTime;
-                }
-            }
-        }
+    for (usize i = 0; i < count; ++i)
+    {
+        usize idx = (cursor + i) % count;
+        const WorkerContext& w = *_workers[idx];
+        if (!w.ready.load(std::memory_order_acquire))
+            continue;
 
-        while (timerWheel.timeToNextTickMillis(currentLoopTime) == 0)
+        u32 load = w.activeSessions.load(std::memory_order_relaxed);
+        if (load < bestLoad)
         {
-            timerWheel.processExpired([&](ink::TimerNode* n) {
-                Session* s = static_cast<Session*>(n);
-                releaseSession(s);
-            });
+            best = static_cast<i32>(idx);
+            bestLoad = load;
         }
     }
 
-    close(listenFd);
-    close(epfd);
-#endif
+    cursor++;
+    return best;
+}
 
-#ifdef USE_IOURING
-    io_uring_params io_params = {};
-    io_params.sq_entries = 4096;
-    io_params.cq_entries = 8192;
-    io_params.flags = IORING_SETUP_SQPOLL | IORING_SETUP_SQ_AFF;
-    io_params.sq_thread_idle = TIMERWHELL_TICK_INTERVAL;
+void EventLoop::runAcceptor(socket_t listenFd)
+{
+    const bool useMsgRing = _backend == IoBackend::IoUring;
 
+    // Only used to post MSG_RING completions into the workers' rings
     io_uring ring = {};
-
-    int ring_res = io_uring_queue_init_params(io_params.sq_entries, &ring, &io_params);
-    if (ring_res < 0)
+    if (useMsgRing)
     {
-        INK_ERROR << "Thread " << threadIdx << " io_uring init failed: " << strerror(-ring_res);
-        close(listenFd);
-        return;
+        int ret = io_uring_queue_init(64, &ring, 0);
+        if (ret < 0)
+        {
+            INK_ERROR << "Acceptor io_uring init failed: " << strerror(-ret);
+            close(listenFd);
+            return;
+        }
     }
 
-    u32 required_features = IORING_FEAT_FAST_POLL | IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP;
-    INK_ASSERT_MSG((io_params.features & required_features) == required_features, "Params flags were not setted.");
-
-    // void* poolBase = sessionPool.getRawBuffer();
-    // size_t poolSize = sessionPool.getRawBufferSize();
-
-    // iovec iov;
-    // iov.iov_base = poolBase;
-    // iov.iov_len  = poolSize;
-
-    // int ret = io_uring_register_buffers(&ring, &iov, 1);
-    // INK_ASSERT_MSG(ret < 0, std::string("Buffer registration failed: ") + strerror(-ret));
-
-    auto releaseSession = [&](Session* s) {
-        INK_ASSERT_MSG(s->getStatus() == SessionStatus::Closing, "Cannot release a session that is not closing...");
-        s->setStatus(SessionStatus::Closed);
-        s->shutdown();
-        timerWheel.unlink(s);
-    };
-
-    auto tryFreeSession = [&](Session* s) {
-        INK_ASSERT_MSG(s->getStatus() == SessionStatus::Closed, "Cannot free a session that is not closed...");
-        // INK_DEBUG << "[Final] Freeing session " << s;
-        s->~Session();
-        sessionPool->release(s);
-    };
-
-    io_uring_sqe *sqe = io_uring_get_sqe(&ring);
-    INK_ASSERT_MSG(sqe, "Sqe is null");
-
-    io_uring_prep_accept(sqe, listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    // epoll workers to wake once the current accept batch is queued
+    std::vector<u8> pendingWake(_workers.size(), 0);
+    u32 cursor = 0;
 
-    // keeps the request alive in the kernel
-    sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
-
-    // identifier of the submition of the listener
-    io_uring_sqe_set_data64(sqe, LISTENER_TAG);
-
-    // submit the ring and notifies the kernel thread
-    io_uring_submit(&ring);
-
-    // Kernel timespec format to pass on io_uring_wait_cqe_timeout;
-    __kernel_timespec kts = {};
-
-    auto getSqeSafe = [&](io_uring* r) -> io_uring_sqe* {
-        io_uring_sqe* sqe = io_uring_get_sqe(r);
-        if (!sqe) {
-            // SQ Ring is full! Flush it to the kernel to free up space.
-            io_uring_submit(r);
-            sqe = io_uring_get_sqe(r);
-        }
-        return sqe;
-    };
+    pollfd pfd = {};
+    pfd.fd = listenFd;
+    pfd.events = POLLIN;
 
     while (_running)
     {
-        io_uring_cqe* cqe;
-        u64 currentLoopTime = ink::utils::nowMillis();
-        u64 timeout = timerWheel.timeToNextTickMillis(currentLoopTime);
+        // Bounded wait so stop() is noticed
+        if (poll(&pfd, 1, TIMERWHELL_TICK_INTERVAL) <= 0)
+            continue;
 
-        kts.tv_sec  = timeout / 1000;
-        kts.tv_nsec = (timeout % 1000) * 1000000;
+        while (true)
+        {
+            int clientSock = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (clientSock < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    INK_ERROR << "Acceptor accept4 failed: " << strerror(errno);
+                break;
+            }
 
-        int ret = io_uring_wait_cqe_timeout(&ring, &cqe, &kts);
+            i32 idx = pickWorker(cursor);
+            if (idx < 0)
+            {
+                close(clientSock);
+                continue;
+            }
 
-        u32 head;
-        u32 count = 0;
+            WorkerContext& target = *_workers[idx];
+            // Counted now so the rest of the burst sees the new load before the worker adopts it
+            target.activeSessions.fetch_add(1, std::memory_order_relaxed);
 
-        // Check if we actually have CQEs to process
-        if (ret == 0 || ret == -ETIME)
-        {
-            io_uring_for_each_cqe(&ring, head, cqe)
+            if (useMsgRing)
             {
-                count++;
-                u64 tag = (u64)io_uring_cqe_get_data(cqe);
-
-                if (tag == LISTENER_TAG)
-                {
-                    if (cqe->res >= 0)
-                    {
-                        Session* s = sessionPool->acquire();
-                        new (s) Session(cqe->res);
-
-                        // INK_DEBUG << "[Conn] New Session: " << s << " threadIdx: " << threadIdx;
-                        timerWheel.update(s);
-
-                        io_uring_sqe* rsqe = getSqeSafe(&ring);
-                        if (rsqe)
-                            s->onReadReady(rsqe);
-                        else
-                        {
-                            INK_WARN << "[Conn] Dropping connection, SQ is full!";
-
-                            s->setStatus(Closing);
-                            releaseSession(s);
-                            tryFreeSession(s);
-                        }
-                    }
-                    else if (cqe->res != -EAGAIN && cqe->res != -ECONNABORTED)
-                    {
-                        INK_ERROR << "Multishot Accept failed: " << strerror(-cqe->res);
-                    }
-
-                    if (!(cqe->flags & IORING_CQE_F_MORE))
-                    {
-                        // INK_DEBUG << "Re-arming multishot listener on thread " << threadIdx;
-                        io_uring_sqe* acc_sqe = getSqeSafe(&ring);
-                        io_uring_prep_accept(acc_sqe, listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
-                        acc_sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
-                        io_uring_sqe_set_data64(acc_sqe, LISTENER_TAG);
-                    }
+                io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+                if (!sqe) {
+                    io_uring_submit(&ring);
+                    sqe = io_uring_get_sqe(&ring);
                 }
-                else
+                if (!sqe)
                 {
-                    IoRequest* io_req = reinterpret_cast<IoRequest*>(tag);
-                    Session* s = io_req->session;
-
-                    bool is_notif = (cqe->flags & IORING_CQE_F_NOTIF) != 0;
-                    bool has_more = (cqe->flags & IORING_CQE_F_MORE) != 0;
-                    i32 res = cqe->res;
-
-                    // INK_DEBUG << "[IO] Completion for " << s
-                    //           << " Op: " << (int)io_req->optype
-                    //           << " Res: " << res << " Notif: " << is_notif;
-
-                    if (s->getStatus() == SessionStatus::Closing && !s->hasPendingIo())
-                    {
-                        releaseSession(s);
-                        tryFreeSession(s);
-                    }
-                    else if (s->getStatus() == SessionStatus::Active)
-                    {
-                        if (io_req->optype == OperationType::Read)
-                        {
-                            // processRead handles clearing the IO_READING flag internally
-                            if (!s->processRead(res, &ring))
-                            {
-                                s->setStatus(Closing);
-                            }
-                        }
-                        else if (io_req->optype == OperationType::Write)
-                        {
-                            // Only set this to true so hasPendingIo() knows not to kill
-                            // the session while wait for the notification CQE.
-                            if (has_more)
-                                s->updateIoState(IO_WAITING_ZC, true);
-
-                            if (!s->processWrite(res, is_notif, &ring))
-                            {
-                                s->setStatus(SessionStatus::Closing);
-                            }
-                        }
-
-                        if (currentLoopTime - s->lastActivityTick >= TIMERWHELL_TICK_INTERVAL)
-                        {
-                            timerWheel.update(s);
-                            s->lastActivityTick = currentLoopTime;
-                        }
-                    }
+                    INK_WARN << "[Conn] Acceptor ring has no free SQE, dropping connection";
+                    target.activeSessions.fetch_sub(1, std::memory_order_relaxed);
+                    close(clientSock);
+                    continue;
                 }
+
+                // The worker gets a CQE tagged HANDOFF_TAG with the fd in res, only failures complete here
+                io_uring_prep_msg_ring(sqe, target.ringFd, static_cast<u32>(clientSock), HANDOFF_TAG, 0);
+                sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
+                io_uring_sqe_set_data64(sqe, (static_cast<u64>(idx) << 32) | static_cast<u32>(clientSock));
+            }
+            else if (target.handoffQueue.push(clientSock))
+            {
+                pendingWake[idx] = 1;
+            }
+            else
+            {
+                INK_WARN << "[Conn] Hand-off queue of thread " << target.threadIdx << " is full, dropping connection";
+                target.activeSessions.fetch_sub(1, std::memory_order_relaxed);
+                close(clientSock);
             }
         }
 
-        if (count > 0) io_uring_cq_advance(&ring, count);
-
-        while (timerWheel.timeToNextTickMillis(currentLoopTime) == 0)
+        if (useMsgRing)
         {
-            timerWheel.processExpired([&](ink::TimerNode* n) {
-                Session* s = static_cast<Session*>(n);
-
-                // INK_DEBUG << "[Timer] Session timed out: " << s;
+            io_uring_submit(&ring);
 
-                s->setStatus(SessionStatus::Closing);
-                s->close();
-
-                if (!s->hasPendingIo())
-                {
-                    releaseSession(s);
-                    tryFreeSession(s);
-                }
-            });
+            io_uring_cqe* cqe;
+            while (io_uring_peek_cqe(&ring, &cqe) == 0)
+            {
+                u64 data = io_uring_cqe_get_data64(cqe);
+                INK_WARN << "[Conn] Hand-off failed: " << strerror(-cqe->res);
+                _workers[data >> 32]->activeSessions.fetch_sub(1, std::memory_order_relaxed);
+                close(static_cast<int>(data & 0xffffffff));
+                io_uring_cqe_seen(&ring, cqe);
+            }
         }
+        else
+        {
+            for (usize i = 0; i < pendingWake.size(); ++i)
+            {
+                if (!pendingWake[i]) continue;
+                pendingWake[i] = 0;
 
-        io_uring_submit(&ring);
+                u64 one = 1;
+                if (write(_workers[i]->wakeFd, &one, sizeof(one)) < 0)
+                    INK_WARN << "Waking thread " << _workers[i]->threadIdx << " failed: " << strerror(errno);
+            }
+        }
     }
 
-    io_uring_queue_exit(&ring);
+    if (useMsgRing)
+        io_uring_queue_exit(&ring);
     close(listenFd);
-#endif
 }
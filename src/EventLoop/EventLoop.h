@@ -4,11 +4,15 @@
 #pragma once
 
 #include "WarpDefs.h"
+#include "Mailbox.h"
 #include <thread>
 #include <vector>
 #include <atomic>
+#include <memory>
+#include <string>
 
 class Session;
+struct WorkerContext;
 
 class WARP_API EventLoop {
 public:
@@ -18,12 +22,69 @@ public:
     void start();
     void stop();
 
+    /**
+     * @brief Queues @p task to run on the thread of worker @p workerIdx. Safe from any thread.
+     * @return false if the worker is not running or its mailbox is full.
+     */
+    bool post(u32 workerIdx, WorkerTask task);
+
+    /** @brief Posts a copy of @p task to every running worker. @return Workers that accepted it. */
+    u32 broadcast(const WorkerTask& task);
+
+    /** @brief Valid worker indexes for post() are [0, workerCount()). */
+    u32 workerCount() const noexcept { return static_cast<u32>(_workers.size()); }
+
+    /** @brief Worker running on the calling thread, null outside of the event loop threads. */
+    static WorkerContext* currentWorker() noexcept;
+
 private:
-    // The main function running on every thread
-    void runWorker(i32 threadIdx);
+    // The main function running on every thread, listenFd is SOCKET_ERROR_VALUE in AcceptMode::Central
+    void runWorker(WorkerContext* worker, socket_t listenFd);
+
+    /**
+     * @brief AcceptMode::Central: accepts on the only listener and hands every
+     *        connection to the least loaded worker until _running drops.
+     */
+    void runAcceptor(socket_t listenFd);
+
+    /**
+     * @brief Index of the ready worker with the fewest sessions, -1 if none is ready.
+     * @param cursor Rotating start so ties are spread round robin.
+     */
+    i32 pickWorker(u32& cursor) const;
+
+    /** @brief Creates the SO_REUSEPORT listener for one worker. */
+    static socket_t createListener(i32 threadIdx);
+
+    /**
+     * @brief Attaches a classic BPF program to the reuseport group that picks the
+     *        listener of the worker pinned to the CPU which received the SYN.
+     * @param listeners One per worker in worker order, SOCKET_ERROR_VALUE where it failed to open.
+     */
+    static bool attachCpuSteering(const std::vector<socket_t>& listeners);
+
+    // Backend loops, both own the listener's sessions until _running drops (EpollLoop.cpp / IoUringLoop.cpp)
+    void runEpollWorker(WorkerContext& worker, socket_t listenFd);
+    void runIoUringWorker(WorkerContext& worker, socket_t listenFd);
+
+    /** @brief Applies the "backend" setting, probing the kernel when it is left on auto. */
+    static IoBackend resolveBackend();
+
+    /**
+     * @brief Checks the running kernel can host the io_uring loop with the configured ring_mode.
+     * @param reason Set to a short explanation when the probe fails.
+     */
+    static bool probeIoUring(std::string& reason);
 
     std::atomic<bool> _running;
     std::vector<std::thread> _threads;
+    // Outlive every thread, the acceptor reads the workers' load and queues
+    std::vector<std::unique_ptr<WorkerContext>> _workers;
+    IoBackend _backend = IoBackend::Epoll;
+
+    // Owner of the single SQPOLL thread every worker attaches to in RingSetupMode::SharedSqPoll
+    io_uring _sqPollRing = {};
+    bool _hasSqPollRing = false;
 };
 
 #endif // EVENT_LOOP_H
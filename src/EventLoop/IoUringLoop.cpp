@@ -0,0 +1,485 @@
+#include "EventLoop.h"
+
+#include <ink/TimerWheel.h>
+
+#include "ProvidedBufferRing.h"
+#include "Server/Session.h"
+#include "Settings/Settings.h"
+#include "WorkerContext.h"
+
+static inline char listener_marker;
+#define LISTENER_TAG ((u64)&listener_marker)
+#define RECV_BUFFER_GROUP 0
+
+// io_uring_register_napi arrived in liburing 2.6
+#ifdef IO_URING_CHECK_VERSION
+#if !IO_URING_CHECK_VERSION(2, 6)
+#define WARP_HAS_URING_NAPI 1
+#endif
+#endif
+
+#define REQUIRED_RING_FEATURES (IORING_FEAT_FAST_POLL | IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP)
+
+bool EventLoop::probeIoUring(std::string& reason)
+{
+    io_uring_params params = {};
+    switch (Settings::getSettings().ring_mode)
+    {
+        case RingSetupMode::SqPollPerWorker:
+        case RingSetupMode::SharedSqPoll:
+            params.flags = IORING_SETUP_SQPOLL;
+            break;
+        case RingSetupMode::DeferTaskrun:
+            params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN | IORING_SETUP_COOP_TASKRUN;
+            break;
+    }
+
+    // Also fails when io_uring is disabled by sysctl or seccomp
+    io_uring ring = {};
+    int ret = io_uring_queue_init_params(8, &ring, &params);
+    if (ret < 0)
+    {
+        reason = std::string("ring setup failed: ") + strerror(-ret);
+        return false;
+    }
+
+    bool supported = true;
+    if ((params.features & REQUIRED_RING_FEATURES) != REQUIRED_RING_FEATURES)
+    {
+        reason = "missing FAST_POLL/SINGLE_MMAP/NODROP features";
+        supported = false;
+    }
+
+    io_uring_probe* probe = io_uring_get_probe_ring(&ring);
+    if (!probe)
+    {
+        reason = "opcode probe unsupported";
+        supported = false;
+    }
+    else
+    {
+        // SEND_ZC (6.0) also implies multishot accept and provided buffer rings (5.19).
+        // SENDMSG carries queued bodies, SENDMSG_ZC is probed per worker and optional
+        static constexpr int requiredOps[] = {
+            IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_SEND_ZC, IORING_OP_SENDMSG,
+            IORING_OP_ASYNC_CANCEL, IORING_OP_CLOSE, IORING_OP_SHUTDOWN, IORING_OP_MSG_RING
+        };
+
+        for (int op : requiredOps)
+        {
+            if (!io_uring_opcode_supported(probe, op))
+            {
+                reason = "opcode " + std::to_string(op) + " unsupported";
+                supported = false;
+                break;
+            }
+        }
+        io_uring_free_probe(probe);
+    }
+
+    io_uring_queue_exit(&ring);
+    return supported;
+}
+
+void EventLoop::runIoUringWorker(WorkerContext& worker, socket_t listenFd)
+{
+    auto& settings = Settings::getSettings();
+    i32 threadIdx = worker.threadIdx;
+
+    // TimerWheel that marks n seconds until session expires
+    // handling keep alives sessions
+    ink::TimerWheel timerWheel(settings.connection_timeout_ms/1000, TIMERWHELL_TICK_INTERVAL);
+
+    // ObjectPool to reduce session allocation
+    auto sessionPool = std::make_unique<ObjectPool<Session, SESSION_POOL_SIZE>>();
+
+    io_uring_params io_params = {};
+    io_params.sq_entries = 4096;
+    io_params.cq_entries = 8192;
+    io_params.sq_thread_idle = TIMERWHELL_TICK_INTERVAL;
+
+    const bool deferTaskrun = settings.ring_mode == RingSetupMode::DeferTaskrun;
+    switch (settings.ring_mode)
+    {
+        case RingSetupMode::SqPollPerWorker:
+            // SQ_AFF with the zeroed sq_thread_cpu binds every SQ thread to CPU 0
+            io_params.flags = IORING_SETUP_SQPOLL | IORING_SETUP_SQ_AFF;
+            break;
+        case RingSetupMode::SharedSqPoll:
+            if (!_hasSqPollRing)
+            {
+                INK_ERROR << "Thread " << threadIdx << " has no shared SQPOLL ring to attach to";
+                return;
+            }
+            io_params.flags = IORING_SETUP_SQPOLL | IORING_SETUP_ATTACH_WQ;
+            io_params.wq_fd = _sqPollRing.ring_fd;
+            break;
+        case RingSetupMode::DeferTaskrun:
+            // Completions run only when this thread enters the kernel, so no IPIs and no SQ thread
+            io_params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN | IORING_SETUP_COOP_TASKRUN;
+            break;
+    }
+
+    io_uring ring = {};
+
+    int ring_res = io_uring_queue_init_params(io_params.sq_entries, &ring, &io_params);
+    if (ring_res < 0)
+    {
+        INK_ERROR << "Thread " << threadIdx << " io_uring init failed: " << strerror(-ring_res);
+        return;
+    }
+
+    INK_ASSERT_MSG((io_params.features & REQUIRED_RING_FEATURES) == REQUIRED_RING_FEATURES, "Params flags were not setted.");
+
+    // NAPI busy polling of the sockets this ring waits on (Linux 6.9)
+    const u64 busyPollUs = settings.busy_poll_us;
+    if (busyPollUs > 0)
+    {
+#ifdef WARP_HAS_URING_NAPI
+        io_uring_napi napi = {};
+        napi.busy_poll_to = settings.busy_poll_us;
+        napi.prefer_busy_poll = 1;
+
+        int ret = io_uring_register_napi(&ring, &napi);
+        if (ret < 0)
+            INK_WARN << "Thread " << threadIdx << " io_uring NAPI busy polling unavailable: " << strerror(-ret);
+#else
+        INK_WARN << "Thread " << threadIdx << " liburing too old for NAPI busy polling, only spinning in userspace";
+#endif
+    }
+
+    // Kernel-selected recv buffers: sessions only own read memory while a request is partial
+    std::unique_ptr<ProvidedBufferRing> bufRing;
+    if (settings.provided_buffers)
+    {
+        bufRing = std::make_unique<ProvidedBufferRing>(&ring, RECV_BUFFER_GROUP,
+                                                       settings.provided_buffer_count,
+                                                       settings.provided_buffer_size);
+        if (bufRing->isValid())
+            worker.bufRing = bufRing.get();
+        else
+            INK_WARN << "Thread " << threadIdx << " provided buffers unavailable, using per-session read buffers";
+    }
+
+    // Sparse fixed-file table: accepted sockets never enter the process fd table,
+    // so per-op fdget/fdput and fd table contention between workers go away
+    if (settings.direct_descriptors)
+    {
+        int ret = io_uring_register_files_sparse(&ring, settings.direct_descriptor_table_size);
+        if (ret == 0)
+            worker.directFds = true;
+        else
+            INK_WARN << "Thread " << threadIdx << " direct descriptors unavailable: " << strerror(-ret);
+    }
+
+    // Gathered shared bodies only go zero-copy where the kernel has SENDMSG_ZC (6.1)
+    if (io_uring_probe* probe = io_uring_get_probe_ring(&ring))
+    {
+        worker.sendmsgZc = io_uring_opcode_supported(probe, IORING_OP_SENDMSG_ZC);
+        io_uring_free_probe(probe);
+    }
+    if (!worker.sendmsgZc)
+        INK_WARN << "Thread " << threadIdx << " sendmsg_zc unavailable, shared bodies use a plain sendmsg";
+
+    worker.ring = &ring;
+    worker.ringFd = ring.ring_fd;
+    worker.mailbox.attachRing(ring.ring_fd);
+    // Wakeups this thread posts to other workers ride on this ring's next submit
+    Mailbox::bindSenderRing(&ring);
+
+    // void* poolBase = sessionPool.getRawBuffer();
+    // size_t poolSize = sessionPool.getRawBufferSize();
+
+    // iovec iov;
+    // iov.iov_base = poolBase;
+    // iov.iov_len  = poolSize;
+
+    // int ret = io_uring_register_buffers(&ring, &iov, 1);
+    // INK_ASSERT_MSG(ret < 0, std::string("Buffer registration failed: ") + strerror(-ret));
+
+    auto releaseSession = [&](Session* s) {
+        INK_ASSERT_MSG(s->getStatus() == SessionStatus::Closing, "Cannot release a session that is not closing...");
+        s->setStatus(SessionStatus::Closed);
+        s->shutdown();
+        timerWheel.unlink(s);
+    };
+
+    auto tryFreeSession = [&](Session* s) {
+        INK_ASSERT_MSG(s->getStatus() == SessionStatus::Closed, "Cannot free a session that is not closed...");
+        // INK_DEBUG << "[Final] Freeing session " << s;
+        s->~Session();
+        sessionPool->release(s);
+        worker.activeSessions.fetch_sub(1, std::memory_order_relaxed);
+    };
+
+    // Starts serving a connected socket, accepted here or handed off by the central acceptor
+    auto adoptConnection = [&](socket_t clientSock) {
+        Session* s = sessionPool->acquire();
+        new (s) Session(clientSock, &worker);
+        worker.stats.recordAccept(s->incomingCpu(), worker.cpu);
+
+        // INK_DEBUG << "[Conn] New Session: " << s << " threadIdx: " << threadIdx;
+        timerWheel.update(s);
+
+        io_uring_sqe* rsqe = worker.getSqe();
+        if (rsqe)
+            s->onReadReady(rsqe);
+        else
+        {
+            INK_WARN << "[Conn] Dropping connection, SQ is full!";
+
+            s->setStatus(Closing);
+            releaseSession(s);
+            tryFreeSession(s);
+        }
+    };
+
+    // Multishot accept keeps the request alive in the kernel
+    auto armAccept = [&](io_uring_sqe* asqe) {
+        if (worker.directFds)
+            io_uring_prep_multishot_accept_direct(asqe, listenFd, NULL, NULL, 0);
+        else
+            io_uring_prep_multishot_accept(asqe, listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        // identifier of the submition of the listener
+        io_uring_sqe_set_data64(asqe, LISTENER_TAG);
+    };
+
+    // No listener in AcceptMode::Central, connections arrive as HANDOFF_TAG completions
+    if (listenFd != SOCKET_ERROR_VALUE)
+    {
+        io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+        INK_ASSERT_MSG(sqe, "Sqe is null");
+
+        armAccept(sqe);
+
+        // submit the ring and notifies the kernel thread
+        io_uring_submit(&ring);
+    }
+
+    worker.ready.store(true, std::memory_order_release);
+
+    // Kernel timespec format to pass on io_uring_wait_cqe_timeout;
+    __kernel_timespec kts = {};
+
+    auto getSqeSafe = [&](io_uring* r) -> io_uring_sqe* {
+        io_uring_sqe* sqe = io_uring_get_sqe(r);
+        if (!sqe) {
+            // SQ Ring is full! Flush it to the kernel to free up space.
+            io_uring_submit(r);
+            sqe = io_uring_get_sqe(r);
+        }
+        return sqe;
+    };
+
+    // Set when the last mailbox drain hit its batch limit
+    bool mailboxBacklog = false;
+
+    while (_running)
+    {
+        io_uring_cqe* cqe;
+        u64 currentLoopTime = ink::utils::nowMillis();
+        u64 timeout = mailboxBacklog ? 0 : timerWheel.timeToNextTickMillis(currentLoopTime);
+
+        // Busy poll: burn up to busy_poll_us checking the CQ before sleeping
+        if (busyPollUs > 0 && timeout != 0 && io_uring_cq_ready(&ring) == 0)
+        {
+            u64 spinStart = monotonicMicros();
+            u64 now = spinStart;
+            do {
+                // With DEFER_TASKRUN completions are only posted when this thread enters the kernel
+                if (deferTaskrun)
+                    io_uring_submit_and_get_events(&ring);
+                if (io_uring_cq_ready(&ring) > 0)
+                    break;
+                now = monotonicMicros();
+            } while (now - spinStart < busyPollUs);
+            worker.stats.spinUs += now - spinStart;
+
+            if (io_uring_cq_ready(&ring) > 0)
+            {
+                worker.stats.spinHits++;
+                timeout = 0;
+            }
+        }
+
+        kts.tv_sec  = timeout / 1000;
+        kts.tv_nsec = (timeout % 1000) * 1000000;
+
+        u64 waitStart = timeout != 0 ? monotonicMicros() : 0;
+
+        // Without an SQ thread, flush everything queued last iteration in the same syscall as the wait
+        int ret = deferTaskrun
+            ? io_uring_submit_and_wait_timeout(&ring, &cqe, 1, &kts, nullptr)
+            : io_uring_wait_cqe_timeout(&ring, &cqe, &kts);
+
+        if (timeout != 0)
+        {
+            worker.stats.blockedUs += monotonicMicros() - waitStart;
+            worker.stats.wakeups++;
+        }
+
+        u32 head;
+        u32 count = 0;
+
+        // Check if we actually have CQEs to process
+        if (ret >= 0 || ret == -ETIME)
+        {
+            io_uring_for_each_cqe(&ring, head, cqe)
+            {
+                count++;
+                u64 tag = (u64)io_uring_cqe_get_data(cqe);
+
+                if (tag == LISTENER_TAG)
+                {
+                    if (cqe->res >= 0)
+                    {
+                        worker.activeSessions.fetch_add(1, std::memory_order_relaxed);
+                        adoptConnection(cqe->res);
+                    }
+                    else if (cqe->res == -ENFILE && worker.directFds)
+                    {
+                        INK_WARN << "[Conn] Direct descriptor table full on thread " << threadIdx;
+                    }
+                    else if (cqe->res != -EAGAIN && cqe->res != -ECONNABORTED)
+                    {
+                        INK_ERROR << "Multishot Accept failed: " << strerror(-cqe->res);
+                    }
+
+                    if (!(cqe->flags & IORING_CQE_F_MORE))
+                    {
+                        // INK_DEBUG << "Re-arming multishot listener on thread " << threadIdx;
+                        io_uring_sqe* acc_sqe = getSqeSafe(&ring);
+                        armAccept(acc_sqe);
+                    }
+                }
+                else if (tag == MAILBOX_TAG)
+                {
+                    // Only a wakeup, the mailbox is drained at the end of the iteration
+                }
+                else if (tag == HANDOFF_TAG)
+                {
+                    // Already counted in activeSessions by the acceptor
+                    adoptConnection(cqe->res);
+                }
+                else if (tag != 0) // untagged SQEs (nops, cancels) have nothing to resume
+                {
+                    IoRequest* io_req = reinterpret_cast<IoRequest*>(tag);
+                    Session* s = io_req->session;
+
+                    bool is_notif = (cqe->flags & IORING_CQE_F_NOTIF) != 0;
+                    bool has_more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+                    i32 res = cqe->res;
+
+                    // INK_DEBUG << "[IO] Completion for " << s
+                    //           << " Op: " << (int)io_req->optype
+                    //           << " Res: " << res << " Notif: " << is_notif;
+
+                    if (s->getStatus() == SessionStatus::Closing)
+                    {
+                        // A closing session will never look at the data, hand the buffer straight back
+                        if (cqe->flags & IORING_CQE_F_BUFFER)
+                            worker.bufRing->recycle(static_cast<u16>(cqe->flags >> IORING_CQE_BUFFER_SHIFT));
+
+                        // Only retire the in-flight state so the session can be freed once the kernel is done with it
+                        if (io_req->optype == OperationType::Read)
+                        {
+                            if (!has_more)
+                                s->updateIoState(IO_READING, false);
+                        }
+                        else if (is_notif)
+                        {
+                            s->updateIoState(IO_WAITING_ZC, false);
+                        }
+                        else
+                        {
+                            s->updateIoState(IO_WRITING, false);
+                            if (has_more)
+                                s->updateIoState(IO_WAITING_ZC, true);
+                        }
+
+                        if (!s->hasPendingIo())
+                        {
+                            releaseSession(s);
+                            tryFreeSession(s);
+                        }
+                    }
+                    else if (s->getStatus() == SessionStatus::Active)
+                    {
+                        if (io_req->optype == OperationType::Read)
+                        {
+                            // processRead handles clearing the IO_READING flag internally
+                            if (!s->processRead(res, cqe->flags, &ring))
+                            {
+                                s->setStatus(Closing);
+                            }
+                        }
+                        else if (io_req->optype == OperationType::Write)
+                        {
+                            // Only set this to true so hasPendingIo() knows not to kill
+                            // the session while wait for the notification CQE.
+                            if (has_more)
+                                s->updateIoState(IO_WAITING_ZC, true);
+
+                            if (!s->processWrite(res, is_notif, &ring))
+                            {
+                                s->setStatus(SessionStatus::Closing);
+                            }
+                        }
+
+                        // A recv left armed (multishot or single shot) would pin the socket forever
+                        if (s->getStatus() != SessionStatus::Active && s->isReadInFlight())
+                        {
+                            io_uring_sqe* csqe = getSqeSafe(&ring);
+                            if (csqe) s->cancelRead(csqe);
+                        }
+
+                        if (currentLoopTime - s->lastActivityTick >= TIMERWHELL_TICK_INTERVAL)
+                        {
+                            timerWheel.update(s);
+                            s->lastActivityTick = currentLoopTime;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (count > 0) io_uring_cq_advance(&ring, count);
+
+        while (timerWheel.timeToNextTickMillis(currentLoopTime) == 0)
+        {
+            timerWheel.processExpired([&](ink::TimerNode* n) {
+                Session* s = static_cast<Session*>(n);
+
+                // INK_DEBUG << "[Timer] Session timed out: " << s;
+
+                s->setStatus(SessionStatus::Closing);
+
+                // Shutdown first so any armed recv completes and releases its file reference
+                s->shutdown();
+                s->close();
+
+                if (!s->hasPendingIo())
+                {
+                    releaseSession(s);
+                    tryFreeSession(s);
+                }
+            });
+
+            worker.responseHeads.refreshDate(time(nullptr));
+        }
+
+        mailboxBacklog = worker.mailbox.drain(worker, MAILBOX_DRAIN_BATCH);
+
+        if (!deferTaskrun)
+            io_uring_submit(&ring);
+    }
+
+    worker.ready.store(false, std::memory_order_release);
+    Mailbox::bindSenderRing(nullptr);
+
+    bufRing.reset();
+    if (worker.directFds)
+        io_uring_unregister_files(&ring);
+    io_uring_queue_exit(&ring);
+}
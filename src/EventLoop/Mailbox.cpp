@@ -0,0 +1,120 @@
+#include "Mailbox.h"
+
+#include "WorkerContext.h"
+
+namespace {
+
+// Ring of the worker loop running on this thread, if any
+thread_local io_uring* tl_senderRing = nullptr;
+
+// MSG_RING source for threads that run no loop (acceptor, application threads)
+struct ForeignSenderRing {
+    io_uring ring = {};
+    bool valid = false;
+
+    ForeignSenderRing()
+    {
+        int ret = io_uring_queue_init(8, &ring, 0);
+        if (ret < 0)
+            INK_ERROR << "Mailbox sender ring init failed: " << strerror(-ret);
+        else
+            valid = true;
+    }
+
+    ~ForeignSenderRing()
+    {
+        if (valid) io_uring_queue_exit(&ring);
+    }
+};
+
+} // namespace
+
+Mailbox::Mailbox(usize capacity) :
+    _queue(capacity)
+{
+}
+
+void Mailbox::bindSenderRing(io_uring* ring) noexcept
+{
+    tl_senderRing = ring;
+}
+
+bool Mailbox::post(WorkerTask task)
+{
+    if (!_queue.push(std::move(task)))
+        return false;
+
+    // acq_rel pairs with the exchange in drain(): either the worker sees this task, or we wake it
+    if (!_wakePending.exchange(true, std::memory_order_acq_rel))
+        wake();
+
+    return true;
+}
+
+void Mailbox::wake()
+{
+    if (_eventFd >= 0)
+    {
+        u64 one = 1;
+        if (write(_eventFd, &one, sizeof(one)) < 0)
+            INK_WARN << "Mailbox eventfd write failed: " << strerror(errno);
+        return;
+    }
+
+    if (_ringFd < 0)
+        return;
+
+    bool foreign = tl_senderRing == nullptr;
+    io_uring* ring = tl_senderRing;
+    if (foreign)
+    {
+        thread_local ForeignSenderRing senderRing;
+        if (!senderRing.valid) return;
+        ring = &senderRing.ring;
+    }
+
+    io_uring_sqe* sqe = io_uring_get_sqe(ring);
+    if (!sqe) {
+        io_uring_submit(ring);
+        sqe = io_uring_get_sqe(ring);
+    }
+
+    // Untagged on the sending side, so a failure is skipped by the sender's loop
+    io_uring_prep_msg_ring(sqe, _ringFd, 0, MAILBOX_TAG, 0);
+    sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
+    io_uring_sqe_set_data64(sqe, 0);
+
+    if (foreign)
+    {
+        io_uring_submit(ring);
+
+        io_uring_cqe* cqe;
+        while (io_uring_peek_cqe(ring, &cqe) == 0)
+        {
+            INK_WARN << "Mailbox MSG_RING failed: " << strerror(-cqe->res);
+            io_uring_cqe_seen(ring, cqe);
+        }
+    }
+}
+
+bool Mailbox::drain(WorkerContext& worker, usize budget)
+{
+    // Common case: nothing posted since the last drain
+    if (!_wakePending.load(std::memory_order_relaxed) && _queue.empty())
+        return false;
+
+    // Re-open wakeups before popping, a post landing after this point signals again
+    _wakePending.exchange(false, std::memory_order_acq_rel);
+
+    WorkerTask task;
+    for (usize i = 0; i < budget; ++i)
+    {
+        if (!_queue.pop(task))
+            return false;
+
+        task(worker);
+        worker.stats.mailboxTasks++;
+    }
+
+    return !_queue.empty();
+}
@@ -0,0 +1,68 @@
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#pragma once
+
+#include "WarpDefs.h"
+#include "Utils/MpscQueue.h"
+
+#include <atomic>
+#include <functional>
+
+struct WorkerContext;
+
+// Work posted to another worker, always runs on the target worker's thread
+using WorkerTask = std::function<void(WorkerContext&)>;
+
+// user_data of the MSG_RING completion that only wakes a worker up to drain its mailbox
+#define MAILBOX_TAG ((u64)2)
+
+/**
+ * @class Mailbox
+ * @brief Per-worker MPSC inbox of tasks, drained by the owning loop in batches.
+ *
+ * Any thread may post(). Wakeups are coalesced: only the post that finds the mailbox
+ * idle signals the worker, through its eventfd (epoll) or an IORING_OP_MSG_RING into
+ * its ring (io_uring). The MSG_RING is submitted on the posting worker's own ring, or on
+ * a small ring lazily created for threads that do not run a loop.
+ */
+class WARP_API Mailbox {
+public:
+    explicit Mailbox(usize capacity);
+
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+
+    /** @brief Worker side, before the worker is marked ready: the eventfd to bump on post. */
+    void attachEventFd(int eventFd) noexcept { _eventFd = eventFd; }
+
+    /** @brief Worker side, before the worker is marked ready: the ring to MSG_RING on post. */
+    void attachRing(int ringFd) noexcept { _ringFd = ringFd; }
+
+    /** @brief Safe from any thread. @return false if the mailbox is full. */
+    bool post(WorkerTask task);
+
+    /**
+     * @brief Owner thread only. Runs at most @p budget queued tasks.
+     * @return true if tasks are still queued, the loop must not block before draining again.
+     */
+    bool drain(WorkerContext& worker, usize budget);
+
+    /**
+     * @brief Makes the calling worker thread post its MSG_RING wakeups on @p ring,
+     *        flushed by the loop's next submit. Null unbinds.
+     */
+    static void bindSenderRing(io_uring* ring) noexcept;
+
+private:
+    void wake();
+
+    MpscQueue<WorkerTask> _queue;
+    // Set by the post that signalled the worker, cleared when the worker starts draining
+    std::atomic<bool> _wakePending{false};
+
+    int _eventFd = -1;
+    int _ringFd = -1;
+};
+
+#endif // MAILBOX_H
@@ -0,0 +1,68 @@
+#include "ProvidedBufferRing.h"
+
+#include <sys/mman.h>
+
+ProvidedBufferRing::ProvidedBufferRing(io_uring* ring, u16 groupId, u32 entries, u32 bufferSize) :
+    _ring(ring),
+    _groupId(groupId),
+    _entries(entries),
+    _mask(io_uring_buf_ring_mask(entries)),
+    _bufferSize(bufferSize)
+{
+    usize ringBytes = static_cast<usize>(_entries) * sizeof(io_uring_buf);
+    void* ringMem = mmap(nullptr, ringBytes, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (ringMem == MAP_FAILED)
+    {
+        INK_ERROR << "Buffer ring mmap failed: " << strerror(errno);
+        return;
+    }
+
+    io_uring_buf_reg reg = {};
+    reg.ring_addr = reinterpret_cast<u64>(ringMem);
+    reg.ring_entries = _entries;
+    reg.bgid = _groupId;
+
+    int ret = io_uring_register_buf_ring(_ring, &reg, 0);
+    if (ret < 0)
+    {
+        INK_ERROR << "Buffer ring registration failed: " << strerror(-ret);
+        munmap(ringMem, ringBytes);
+        return;
+    }
+
+    usize slabBytes = static_cast<usize>(_entries) * _bufferSize;
+    void* slab = mmap(nullptr, slabBytes, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (slab == MAP_FAILED)
+    {
+        INK_ERROR << "Buffer ring slab mmap failed: " << strerror(errno);
+        io_uring_unregister_buf_ring(_ring, _groupId);
+        munmap(ringMem, ringBytes);
+        return;
+    }
+
+    _bufRing = static_cast<io_uring_buf_ring*>(ringMem);
+    _slab = static_cast<char*>(slab);
+
+    io_uring_buf_ring_init(_bufRing);
+    for (u32 i = 0; i < _entries; ++i)
+    {
+        io_uring_buf_ring_add(_bufRing, buffer(static_cast<u16>(i)), _bufferSize,
+                              static_cast<u16>(i), _mask, static_cast<int>(i));
+    }
+    io_uring_buf_ring_advance(_bufRing, static_cast<int>(_entries));
+}
+
+ProvidedBufferRing::~ProvidedBufferRing()
+{
+    if (!_bufRing) return;
+
+    io_uring_unregister_buf_ring(_ring, _groupId);
+    munmap(_bufRing, static_cast<usize>(_entries) * sizeof(io_uring_buf));
+    munmap(_slab, static_cast<usize>(_entries) * _bufferSize);
+}
+
+void ProvidedBufferRing::recycle(u16 bid) noexcept
+{
+    io_uring_buf_ring_add(_bufRing, buffer(bid), _bufferSize, bid, _mask, 0);
+    io_uring_buf_ring_advance(_bufRing, 1);
+}
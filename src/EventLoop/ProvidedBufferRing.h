@@ -0,0 +1,55 @@
+#ifndef PROVIDED_BUFFER_RING_H
+#define PROVIDED_BUFFER_RING_H
+
+#pragma once
+
+#include "WarpDefs.h"
+
+/**
+ * @class ProvidedBufferRing
+ * @brief Per-worker pool of receive buffers handed to the kernel through a
+ *        registered buffer ring (IORING_REGISTER_PBUF_RING).
+ *
+ * Sessions arm their recv with IOSQE_BUFFER_SELECT and the kernel picks a free
+ * buffer only when data actually arrives, so idle keep-alive connections do not
+ * pin any read memory. The buffer id comes back in the CQE flags and must be
+ * recycled once the completion has been consumed.
+ */
+class WARP_API ProvidedBufferRing {
+public:
+    /**
+     * @param ring       Worker ring the buffers are registered with.
+     * @param groupId    Buffer group id used in sqe->buf_group.
+     * @param entries    Number of buffers, must be a power of two (max 32768).
+     * @param bufferSize Size in bytes of every buffer.
+     */
+    ProvidedBufferRing(io_uring* ring, u16 groupId, u32 entries, u32 bufferSize);
+    ~ProvidedBufferRing();
+
+    ProvidedBufferRing(const ProvidedBufferRing&) = delete;
+    ProvidedBufferRing& operator=(const ProvidedBufferRing&) = delete;
+
+    /** @brief False when the kernel refused the registration (pre 5.19). */
+    bool isValid() const noexcept { return _bufRing != nullptr; }
+
+    u16 groupId() const noexcept { return _groupId; }
+    u32 bufferSize() const noexcept { return _bufferSize; }
+
+    /** @brief Start of the buffer the kernel filled for @p bid. */
+    char* buffer(u16 bid) const noexcept { return _slab + static_cast<usize>(bid) * _bufferSize; }
+
+    /** @brief Hands @p bid back to the kernel once its bytes were consumed. */
+    void recycle(u16 bid) noexcept;
+
+private:
+    io_uring* _ring;
+    io_uring_buf_ring* _bufRing = nullptr;
+    char* _slab = nullptr;
+
+    u16 _groupId;
+    u32 _entries;
+    u32 _mask;
+    u32 _bufferSize;
+};
+
+#endif // PROVIDED_BUFFER_RING_H
@@ -0,0 +1,143 @@
+#ifndef WORKER_CONTEXT_H
+#define WORKER_CONTEXT_H
+
+#pragma once
+
+#include "WarpDefs.h"
+#include "Utils/MpscQueue.h"
+#include "Utils/BumpArena.h"
+#include "Utils/MirrorBuffer.h"
+#include "Utils/SlabPool.h"
+#include "Response/ResponseHeadCache.h"
+#include "Response/ResponseCache.h"
+#include "Mailbox.h"
+
+#include <atomic>
+#include <chrono>
+
+// user_data of the MSG_RING completion carrying a handed-off fd in cqe->res, never a valid IoRequest address
+#define HANDOFF_TAG ((u64)1)
+
+class ProvidedBufferRing;
+
+/** @brief Monotonic clock in microseconds, for loop accounting finer than the timer wheel. */
+inline u64 monotonicMicros() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @struct WorkerStats
+ * @brief Plain per-worker counters, reported when the worker stops.
+ */
+struct WARP_API WorkerStats {
+    // io_uring write path
+    u64 plainSends = 0;
+    u64 zeroCopySends = 0;
+
+    // Accepted connections whose packets were received on this worker's core vs another one
+    u64 localCpuAccepts = 0;
+    u64 remoteCpuAccepts = 0;
+
+    // Tasks other threads posted to this worker's mailbox
+    u64 mailboxTasks = 0;
+
+    // Read turns cut short by the per-session budget (epoll)
+    u64 budgetYields = 0;
+
+    // Sessions closed because their response outgrew max_response_overflow or the worker's share
+    u64 overflowCloses = 0;
+
+    // Requests dispatched to a handler, the arena keeps its own allocation totals
+    u64 requests = 0;
+
+    // Loop waits: time spun on non-blocking polls, spins that found work,
+    // waits that had to block (wakeups) and the time spent blocked in them
+    u64 spinUs = 0;
+    u64 spinHits = 0;
+    u64 wakeups = 0;
+    u64 blockedUs = 0;
+
+    void recordAccept(i32 incomingCpu, i32 workerCpu) noexcept
+    {
+        if (incomingCpu < 0) return;
+        if (incomingCpu == workerCpu) localCpuAccepts++;
+        else remoteCpuAccepts++;
+    }
+};
+
+/**
+ * @struct WorkerContext
+ * @brief Per-thread state owned by EventLoop and shared with every Session
+ *        living on that worker.
+ *
+ * Only ever touched from its own worker thread, so nothing in here needs locking,
+ * except the atomics, the hand-off queue and the mailbox other threads post to.
+ */
+struct WARP_API WorkerContext {
+    EventLoop* loop = nullptr;
+    i32 threadIdx = 0;
+    // Core the worker thread is pinned to
+    i32 cpu = 0;
+    IoBackend backend = IoBackend::Epoll;
+    WorkerStats stats;
+
+    // epoll backend
+    socket_t epollFd = SOCKET_ERROR_VALUE;
+
+    // io_uring backend
+    io_uring* ring = nullptr;
+    // Copy of ring->ring_fd other threads can read without touching the worker's stack
+    int ringFd = -1;
+
+    // Null when provided buffers are disabled or unsupported by the kernel
+    ProvidedBufferRing* bufRing = nullptr;
+
+    // Session sockets are slots in the ring's fixed-file table instead of process fds
+    bool directFds = false;
+
+    // The kernel supports IORING_OP_SENDMSG_ZC, otherwise gathered writes are always plain sendmsg
+    bool sendmsgZc = false;
+
+    // Sessions owned plus connections handed off and not adopted yet, read by the central acceptor
+    std::atomic<u32> activeSessions{0};
+    // Set while the loop is running and can adopt handed-off connections
+    std::atomic<bool> ready{false};
+    // Set once the worker thread is done, including a loop that failed its setup and never got ready
+    std::atomic<bool> exited{false};
+
+    // Central acceptor -> epoll loop: fds are queued here, then wakeFd (an eventfd in epollFd, shared with the mailbox) is bumped
+    MpscQueue<socket_t> handoffQueue{HANDOFF_QUEUE_SIZE};
+    socket_t wakeFd = SOCKET_ERROR_VALUE;
+
+    // Tasks from other threads, see EventLoop::post
+    Mailbox mailbox{MAILBOX_SIZE};
+
+    // Double-mapped session read/write buffers, recycled across sessions
+    MirrorBufferPool buffers;
+    // Blocks write buffers chain on when a response does not fit, capped at worker_response_overflow
+    SlabPool overflowBlocks;
+
+    // Allocation counters of the sessions' request arenas
+    BumpArena::Totals arenaTotals;
+
+    // Pre-serialized response heads and the Date value, refreshed on timer wheel ticks
+    ResponseHeadCache responseHeads;
+
+    // This worker's copy of the responses of endpoints registered with a cache TTL
+    ResponseCache responseCache;
+
+    /** @brief Grabs an SQE, flushing the SQ to the kernel first if it is full. */
+    io_uring_sqe* getSqe() noexcept
+    {
+        io_uring_sqe* sqe = io_uring_get_sqe(ring);
+        if (!sqe) {
+            io_uring_submit(ring);
+            sqe = io_uring_get_sqe(ring);
+        }
+        return sqe;
+    }
+};
+
+#endif // WORKER_CONTEXT_H
@@ -3,19 +3,31 @@
 
 #pragma once
 
-#include <unordered_map>
+#include <cstring>
+#include <memory>
 
 #include "WarpDefs.h"
+#include "Utils/BumpArena.h"
 #include "Utils/Conversions.h"
 #include "Utils/HeadersList.h"
 
+// Query parameters past this count are ignored
+#define MAX_QUERY_PARAMS 32
+
+struct QueryParam
+{
+    std::string_view key;       // Already decoded
+    std::string_view rawValue;  // As it appeared in the query
+    std::string_view value;     // Decoded on first access
+    bool valueDecoded = false;
+};
+
 struct WARP_API RequestData {
     RequestData() :
         method(Method::UNKNOWN),
         path(""),
         version("HTTP/2.0"),
-        body(""),
-        queryParams({}) {}
+        body("") {}
 
     Method method;
     std::string_view path;
@@ -23,8 +35,18 @@ struct WARP_API RequestData {
     std::string_view version;
     std::string_view body;
     std::array<std::string_view, MAX_HEADERS_SIZE> headers;
+    // Headers outside HEADER_LIST, in arrival order
+    std::array<UnknownHeader, MAX_UNKNOWN_HEADERS> unknownHeaders;
+    u8 unknownHeaderCount = 0;
 
-    std::unordered_map<std::string, std::string> queryParams;
+    // Split lazily on the first query parameter access, handlers only see a const request
+    mutable std::array<QueryParam, MAX_QUERY_PARAMS> queryParams;
+    mutable u8 queryParamCount = 0;
+    mutable bool queryParsed = false;
+
+    // Decoded keys and values, at most query.size() bytes taken from the request arena
+    mutable char* queryScratch = nullptr;
+    mutable usize queryScratchUsed = 0;
 
     void clear() noexcept
     {
@@ -34,14 +56,20 @@ struct WARP_API RequestData {
         version = {};
         body = {};
         headers.fill({});
+        unknownHeaderCount = 0;
+        queryParamCount = 0;
+        queryParsed = false;
+        queryScratch = nullptr;
+        queryScratchUsed = 0;
     }
 };
 
 class WARP_API HttpRequest {
 public:
 
-    explicit HttpRequest() :
-        _data()
+    explicit HttpRequest(BumpArena& arena) :
+        _data(),
+        _arena(arena)
     {
         // _data.keep_alive(false);
     }
@@ -129,6 +157,16 @@ public:
             _data.headers[key] = std::string_view(v, vLen);
     }
 
+    /** @return false once MAX_UNKNOWN_HEADERS are stored. */
+    bool addUnknownHeader(std::string_view name, std::string_view value) noexcept
+    {
+        if (_data.unknownHeaderCount >= MAX_UNKNOWN_HEADERS)
+            return false;
+
+        _data.unknownHeaders[_data.unknownHeaderCount++] = { name, value };
+        return true;
+    }
+
     const std::string_view getHeader(const HeaderType& key) const noexcept
     {
         if (key < HeaderType::None)
@@ -137,28 +175,69 @@ public:
         return {};
     }
 
-    const std::unordered_map<std::string, std::string>& queryParams() const noexcept
+    /** @brief Case-insensitive lookup of any header, known ones in O(1). */
+    const std::string_view getHeader(std::string_view name) const noexcept
     {
-        return _data.queryParams;
+        HeaderType key = classifyHeader(name.data(), name.size());
+        if (key != HeaderType::None)
+            return _data.headers[key];
+
+        for (u8 i = 0; i < _data.unknownHeaderCount; ++i)
+        {
+            const UnknownHeader& h = _data.unknownHeaders[i];
+            if (h.name.size() != name.size())
+                continue;
+
+            usize j = 0;
+            while (j < name.size() && header_hash::lower(h.name[j]) == header_hash::lower(name[j])) ++j;
+            if (j == name.size())
+                return h.value;
+        }
+
+        return {};
     }
 
-    void extractQueryParams()
+    /** @brief Headers that are not in HEADER_LIST, in arrival order. */
+    const UnknownHeader* unknownHeaders(usize& count) const noexcept
     {
-        std::string_view target = _data.query;
-        while (!target.empty())
-        {
-            auto amp = target.find('&');
-            std::string_view part = (amp == std::string_view::npos) ? target : target.substr(0, amp);
-            target = (amp == std::string_view::npos) ? std::string_view{} : target.substr(amp + 1);
+        count = _data.unknownHeaderCount;
+        return _data.unknownHeaders.data();
+    }
 
-            auto eq = part.find('=');
-            std::string_view k = (eq == std::string_view::npos) ? part : part.substr(0, eq);
-            std::string_view v = (eq == std::string_view::npos) ? std::string_view{} : part.substr(eq + 1);
+    const std::string_view query() const noexcept
+    {
+        return _data.query;
+    }
 
-            std::string key = Conversions::urlDecode(k);
-            std::string value = Conversions::urlDecode(v);
-            _data.queryParams[std::move(key)] = std::move(value);
-        }
+    /** @brief Decoded value of query parameter @p key (compared decoded, case-sensitive), empty if absent. */
+    std::string_view queryParam(std::string_view key) const
+    {
+        QueryParam* param = findQueryParam(key);
+        return param ? decodedValue(*param) : std::string_view{};
+    }
+
+    bool hasQueryParam(std::string_view key) const
+    {
+        return findQueryParam(key) != nullptr;
+    }
+
+    /** @brief Number of query parameters, for iterating with queryKey() / queryValue(). */
+    usize queryParamCount() const
+    {
+        splitQuery();
+        return _data.queryParamCount;
+    }
+
+    std::string_view queryKey(usize idx) const
+    {
+        splitQuery();
+        return idx < _data.queryParamCount ? _data.queryParams[idx].key : std::string_view{};
+    }
+
+    std::string_view queryValue(usize idx) const
+    {
+        splitQuery();
+        return idx < _data.queryParamCount ? decodedValue(_data.queryParams[idx]) : std::string_view{};
     }
 
     // bool isChunked() const
@@ -189,16 +268,127 @@ public:
     void reset() noexcept
     {
         _data.clear();
-        _presentHeaders = HeaderType::None;
+        _presentHeaders = 0;
     }
 
-    HeaderType& presentHeaders() {
+    /** @brief Forgets the split query, its scratch memory is about to be released. */
+    void dropQueryCache() noexcept
+    {
+        _data.queryParamCount = 0;
+        _data.queryParsed = false;
+        _data.queryScratch = nullptr;
+        _data.queryScratchUsed = 0;
+    }
+
+    /**
+     * @brief Re-points every view into [from, from + len) at the same offset in @p to,
+     *        once the request head was copied there out of a buffer about to be reused.
+     */
+    void relocate(const char* from, const char* to, usize len) noexcept
+    {
+        auto move = [&](std::string_view& sv) {
+            if (sv.data() >= from && sv.data() <= from + len)
+                sv = std::string_view(to + (sv.data() - from), sv.size());
+        };
+
+        move(_data.path);
+        move(_data.query);
+        move(_data.version);
+        move(_data.body);
+        for (auto& header : _data.headers)
+            move(header);
+        for (u8 i = 0; i < _data.unknownHeaderCount; ++i)
+        {
+            move(_data.unknownHeaders[i].name);
+            move(_data.unknownHeaders[i].value);
+        }
+    }
+
+    HeaderMask& presentHeaders() {
         return _presentHeaders;
     }
 
+    /**
+     * @brief Scratch memory released once the request has been answered. Response headers
+     *        are views, values built by the handler can be copied here to outlive it.
+     */
+    BumpArena& arena() const noexcept {
+        return _arena;
+    }
+
+    /** @brief Same memory for std::pmr containers and strings. */
+    std::pmr::memory_resource* memoryResource() const noexcept {
+        return _arena.resource();
+    }
+
 private:
+    /** @brief Splits the query into raw key/value views once per request, decoding keys only. */
+    void splitQuery() const
+    {
+        if (_data.queryParsed)
+            return;
+        _data.queryParsed = true;
+
+        std::string_view target = _data.query;
+        if (target.empty())
+            return;
+
+        _data.queryScratch = static_cast<char*>(_arena.allocate(target.size(), 1));
+
+        while (!target.empty() && _data.queryParamCount < MAX_QUERY_PARAMS)
+        {
+            auto amp = target.find('&');
+            std::string_view part = (amp == std::string_view::npos) ? target : target.substr(0, amp);
+            target = (amp == std::string_view::npos) ? std::string_view{} : target.substr(amp + 1);
+
+            if (part.empty())
+                continue;
+
+            auto eq = part.find('=');
+            QueryParam& param = _data.queryParams[_data.queryParamCount++];
+            param.key = decode((eq == std::string_view::npos) ? part : part.substr(0, eq));
+            param.rawValue = (eq == std::string_view::npos) ? std::string_view{} : part.substr(eq + 1);
+            param.value = {};
+            param.valueDecoded = false;
+        }
+    }
+
+    QueryParam* findQueryParam(std::string_view key) const
+    {
+        splitQuery();
+        for (u8 i = 0; i < _data.queryParamCount; ++i)
+        {
+            if (_data.queryParams[i].key == key)
+                return &_data.queryParams[i];
+        }
+        return nullptr;
+    }
+
+    std::string_view decodedValue(QueryParam& param) const
+    {
+        if (!param.valueDecoded)
+        {
+            param.value = decode(param.rawValue);
+            param.valueDecoded = true;
+        }
+        return param.value;
+    }
+
+    /** @brief Raw view when nothing is escaped, otherwise decoded into the query scratch. */
+    std::string_view decode(std::string_view raw) const
+    {
+        if (raw.find_first_of("%+") == std::string_view::npos)
+            return raw;
+
+        char* out = _data.queryScratch + _data.queryScratchUsed;
+        usize n = Conversions::urlDecode(raw, out);
+        _data.queryScratchUsed += n;
+        return std::string_view(out, n);
+    }
+
     RequestData _data;
-    HeaderType _presentHeaders = HeaderType::None;
+    HeaderMask _presentHeaders = 0;
+    BumpArena& _arena;
 };
 
 #endif // REQUESTMANAGER_H
@@ -0,0 +1,143 @@
+#include "BodyQueue.h"
+
+#include <algorithm>
+#include <string>
+
+#include "Utils/MirrorBuffer.h"
+
+void BodyQueue::push(const MirrorBuffer& writeBuffer, std::shared_ptr<const void> owner, std::string_view body)
+{
+    if (body.empty())
+        return;
+
+    usize gap = writeBuffer.size() - _gaps;
+    if (!owner)
+        _borrowed++;
+
+    _bodies.push_back(Body{std::move(owner), body.data(), body.size(), gap});
+    _gaps += gap;
+    _bytes += body.size();
+}
+
+u32 BodyQueue::gather(const MirrorBuffer& writeBuffer, iovec* iov, usize& total) const noexcept
+{
+    u32 count = 0;
+    usize offset = 0; // Into the write buffer
+    total = 0;
+
+    auto add = [&](const char* data, usize len) {
+        iov[count].iov_base = const_cast<char*>(data);
+        iov[count].iov_len = len;
+        count++;
+        total += len;
+    };
+
+    // The ring and any overflow segments may take several entries
+    auto addBuffered = [&](usize len) {
+        while (len > 0 && count < SEND_IOV_MAX)
+        {
+            usize avail;
+            const char* data = writeBuffer.peek(offset, avail);
+            if (avail == 0)
+                break;
+
+            avail = std::min(avail, len);
+            add(data, avail);
+            offset += avail;
+            len -= avail;
+        }
+        return len == 0;
+    };
+
+    for (usize i = _head; i < _bodies.size(); ++i)
+    {
+        const Body& body = _bodies[i];
+        if (!addBuffered(body.gap) || count == SEND_IOV_MAX)
+            return count;
+
+        add(body.data, body.len);
+    }
+
+    addBuffered(writeBuffer.size() - offset);
+    return count;
+}
+
+void BodyQueue::consume(MirrorBuffer& writeBuffer, usize n)
+{
+    while (n > 0 && !empty())
+    {
+        Body& body = _bodies[_head];
+
+        usize fromBuffer = std::min(n, body.gap);
+        writeBuffer.advanceReadPos(fromBuffer);
+        body.gap -= fromBuffer;
+        _gaps -= fromBuffer;
+        n -= fromBuffer;
+
+        if (body.gap > 0)
+            return;
+
+        usize fromBody = std::min(n, body.len);
+        body.data += fromBody;
+        body.len -= fromBody;
+        _bytes -= fromBody;
+        n -= fromBody;
+
+        if (body.len > 0)
+            return;
+
+        if (!body.owner)
+            _borrowed--;
+        body.owner.reset();
+        _head++;
+    }
+
+    if (empty())
+    {
+        // Keeps the capacity, the next large response reuses it
+        _bodies.clear();
+        _head = 0;
+    }
+
+    if (n > 0)
+        writeBuffer.advanceReadPos(n);
+}
+
+const char* BodyQueue::borrowedIn(const char* begin, const char* end) const noexcept
+{
+    for (usize i = _head; i < _bodies.size() && _borrowed > 0; ++i)
+    {
+        const Body& body = _bodies[i];
+        if (!body.owner && body.data >= begin && body.data + body.len <= end)
+            return body.data;
+    }
+    return nullptr;
+}
+
+void BodyQueue::pinBorrowed(const char* begin, const char* end, const std::shared_ptr<const void>& owner)
+{
+    for (usize i = _head; i < _bodies.size() && _borrowed > 0; ++i)
+    {
+        Body& body = _bodies[i];
+        if (body.owner || body.data < begin || body.data + body.len > end)
+            continue;
+
+        body.owner = owner;
+        _borrowed--;
+    }
+}
+
+void BodyQueue::adoptBorrowed()
+{
+    for (usize i = _head; i < _bodies.size() && _borrowed > 0; ++i)
+    {
+        Body& body = _bodies[i];
+        if (body.owner)
+            continue;
+
+        auto copy = std::make_shared<const std::string>(body.data, body.len);
+        body.data = copy->data();
+        body.owner = std::move(copy);
+        _borrowed--;
+    }
+}
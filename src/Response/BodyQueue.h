@@ -0,0 +1,88 @@
+#ifndef BODYQUEUE_H
+#define BODYQUEUE_H
+
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <vector>
+#include <sys/uio.h>
+
+#include "WarpDefs.h"
+
+class MirrorBuffer;
+
+/**
+ * @class BodyQueue
+ * @brief Response bodies sent from where they already live instead of the write buffer.
+ *
+ * The outbound stream of a session is the write buffer with these bodies spliced in:
+ * each body remembers how many write buffer bytes go out before it, so heads, small
+ * responses and WebSocket frames keep their order around it. gather() describes the
+ * next part of the stream as iovecs for writev/sendmsg, overflow segments of the write
+ * buffer included, consume() releases what the kernel took from both sides.
+ *
+ * A body either has an owner, kept alive until its last byte is released, or is
+ * borrowed and only valid while its request is being handled. Before the request goes
+ * away pinBorrowed() gives those still in the session's read memory an owner that keeps
+ * that memory, adoptBorrowed() copies what is left of the others.
+ */
+class BodyQueue
+{
+public:
+    BodyQueue() = default;
+
+    BodyQueue(const BodyQueue&) = delete;
+    BodyQueue& operator=(const BodyQueue&) = delete;
+
+    /** @brief Queues @p body behind everything currently in @p writeBuffer. @p owner may be null (borrowed). */
+    void push(const MirrorBuffer& writeBuffer, std::shared_ptr<const void> owner, std::string_view body);
+
+    bool empty() const noexcept { return _head == _bodies.size(); }
+    bool hasBorrowed() const noexcept { return _borrowed > 0; }
+
+    /** @brief Queued body bytes not released yet, the write buffer counts on its own. */
+    usize size() const noexcept { return _bytes; }
+
+    /**
+     * @brief Fills @p iov with the start of the outbound stream, up to SEND_IOV_MAX entries.
+     * @param total Set to the bytes described.
+     * @return Entries used, 0 when nothing is queued.
+     */
+    u32 gather(const MirrorBuffer& writeBuffer, iovec* iov, usize& total) const noexcept;
+
+    /** @brief Releases @p n bytes sent from the front of the outbound stream. */
+    void consume(MirrorBuffer& writeBuffer, usize n);
+
+    /** @brief Start of the first borrowed body lying inside [begin, end), null if there is none. */
+    const char* borrowedIn(const char* begin, const char* end) const noexcept;
+
+    /** @brief Hands @p owner to every borrowed body lying inside [begin, end). */
+    void pinBorrowed(const char* begin, const char* end, const std::shared_ptr<const void>& owner);
+
+    /** @brief Copies the unsent rest of every borrowed body into memory the queue owns. */
+    void adoptBorrowed();
+
+    // Storage for an io_uring sendmsg in flight, which reads it at submission
+    msghdr& message() noexcept { return _msg; }
+    iovec* iovecs() noexcept { return _iov; }
+
+private:
+    struct Body {
+        std::shared_ptr<const void> owner; // Null while borrowed
+        const char* data;
+        usize len;
+        usize gap; // Write buffer bytes between the previous body and this one
+    };
+
+    std::vector<Body> _bodies;
+    usize _head = 0;    // First unreleased body
+    usize _gaps = 0;    // Sum of the queued gaps, the write buffer bytes in front of the last body
+    usize _bytes = 0;
+    u32 _borrowed = 0;
+
+    msghdr _msg{};
+    iovec _iov[SEND_IOV_MAX];
+};
+
+#endif // BODYQUEUE_H
@@ -4,7 +4,13 @@
 #pragma once
 
 #include <array>
-#include <ink/RingBuffer.h>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include "Utils/MirrorBuffer.h"
+#include "Response/ResponseHeadCache.h"
+#include "Response/BodyQueue.h"
+#include "Response/ResponseWriter.h"
 
 #include "Utils/StringUtils.h"
 #include "Utils/HeadersList.h"
@@ -23,7 +29,7 @@ struct WARP_API HttpResponseData {
     std::array<HeaderType, MAX_HEADERS_SIZE> active_headers;
     u32 header_count = 0;
 
-    ink::RingBuffer* body;
+    MirrorBuffer* body;
 };
 
 class WARP_API HttpResponse
@@ -31,7 +37,7 @@ class WARP_API HttpResponse
 public:
     HttpResponse() : _data() {}
 
-    static bool writeAll(ink::RingBuffer& rb, const char* data, size_t len)
+    static bool writeAll(MirrorBuffer& rb, const char* data, size_t len)
     {
         size_t written = 0;
         while (written < len) {
@@ -54,53 +60,162 @@ public:
 
         _data.headers[key] = value;
     }
-    void initBody(ink::RingBuffer* writeBufferPtr) { _data.body = writeBufferPtr; }
+    /**
+     * @param heads Worker's head cache, also the source of the Date header. Null writes no Date.
+     * @param bodies Session queue large shared and borrowed bodies are sent from. Null copies them.
+     * @param writer Session's streamed response, null where stream() is not supported.
+     */
+    void initBody(MirrorBuffer* writeBufferPtr, ResponseHeadCache* heads = nullptr, BodyQueue* bodies = nullptr,
+                  ResponseWriter* writer = nullptr)
+    {
+        _data.body = writeBufferPtr;
+        _heads = heads;
+        _bodies = bodies;
+        _writer = writer;
+    }
+
     void setBody(const std::string_view body)
     {
-        char numBuf[24];
-        ink::RingBuffer& out = *_data.body;
+        writeHead(body.length());
+        writeAll(*_data.body, body.data(), body.size());
+    }
+
+    /**
+     * @brief Sends @p body straight from memory kept alive by @p owner, released once sent.
+     * Nothing is copied and the write buffer size does not limit it.
+     */
+    void setSharedBody(std::shared_ptr<const void> owner, const std::string_view body)
+    {
+        if (!_bodies || body.size() < BORROWED_BODY_MIN_SIZE)
+        {
+            setBody(body);
+            return;
+        }
+
+        writeHead(body.length());
+        _bodies->push(*_data.body, std::move(owner), body);
+    }
+
+    void setSharedBody(std::shared_ptr<const std::string> body)
+    {
+        std::string_view view(*body);
+        setSharedBody(std::move(body), view);
+    }
+
+    /**
+     * @brief Sends @p body, e.g. the request's own body, without copying it when possible.
+     * Only has to stay valid until the handler returns: the session sends what it can in
+     * place right away (epoll) and copies whatever is still unsent after that.
+     */
+    void setBorrowedBody(const std::string_view body)
+    {
+        setSharedBody(nullptr, body);
+    }
+
+    /**
+     * @brief Starts a Transfer-Encoding: chunked body, written piece by piece through the
+     *        returned writer instead of setBody(). HTTP/1.0 requests get the raw body and
+     *        Connection: close instead. Endpoint handlers only.
+     * @throws std::logic_error outside of an endpoint handler.
+     */
+    ResponseWriter& stream()
+    {
+        if (!_writer)
+            throw std::logic_error("Response streaming is only available to endpoint handlers");
+
+        if (_writer->isChunked())
+        {
+            writeHeaders();
+            constexpr std::string_view framing = "Transfer-Encoding: chunked\r\n\r\n";
+            writeAll(*_data.body, framing.data(), framing.size());
+        }
+        else
+        {
+            // HTTP/1.0: no framing, the end of the body is the end of the connection
+            addHeader(HeaderType::Connection, CLOSE_CONN_HEADER);
+            writeHeaders();
+            writeAll(*_data.body, "\r\n", 2);
+        }
+
+        _writer->begin(*_data.body);
+        return *_writer;
+    }
+
+private:
+    /** @brief Status line and headers, up to the framing headers. */
+    void writeHeaders()
+    {
+        MirrorBuffer& out = *_data.body;
 
         auto write = [&](std::string_view sv)
         {
             return writeAll(out, sv.data(), sv.size());
         };
 
-        // Status line
-        write(_data.version);
-        write(" ");
-        write(getStatusString(_data.status));
-        write("\r\n");
+        std::string_view head = cachedHead();
+        if (!head.empty())
+        {
+            // Common case: one copy up to the Date line, then whatever else the handler added
+            write(head);
+            for (u32 i = 0; i < _data.header_count; ++i)
+            {
+                HeaderType key = _data.active_headers[i];
+                if (key == HeaderType::Server || key == HeaderType::Connection ||
+                    key == HeaderType::ContentType || key == HeaderType::ContentLength ||
+                    key == HeaderType::TransferEncoding)
+                    continue;
 
-        // Headers
-        for (u32 i = 0; i < _data.header_count; ++i)
+                writeHeader(out, key, _data.headers[key]);
+            }
+        }
+        else
         {
-            HeaderType key = _data.active_headers[i];
+            // Status line
+            write(_data.version);
+            write(" ");
+            write(getStatusString(_data.status));
+            write("\r\n");
 
-            // Skip ContentLength so we never accidentally print it twice
-            if (key == HeaderType::ContentLength) continue;
+            // Headers
+            for (u32 i = 0; i < _data.header_count; ++i)
+            {
+                HeaderType key = _data.active_headers[i];
 
-            // No need to check if empty anymore, we KNOW it's populated
-            write(HeaderStrings[key]);
-            write(": ");
-            write(_data.headers[key]);
-            write("\r\n");
-        }
+                // Framing is always ours, never print it twice
+                if (key == HeaderType::ContentLength || key == HeaderType::TransferEncoding) continue;
 
-        // Write ContentLength explicitily
-        write(HeaderStrings[HeaderType::ContentLength]);
-        write(": ");
-        write(StringUtils::fast_itoa(numBuf, sizeof(numBuf), body.length()));
-        // headers sep
-        write("\r\n\r\n");
+                writeHeader(out, key, _data.headers[key]);
+            }
 
-        // body
-        write(body);
+            if (_heads && _data.headers[HeaderType::Date].empty())
+                writeHeader(out, HeaderType::Date, _heads->date());
+        }
     }
 
-private:
-    HttpResponseData _data;
+    /** @brief Status line, headers, Content-Length and the blank line. */
+    void writeHead(usize contentLength)
+    {
+        writeHeaders();
 
-    std::string_view getStatusString(int status) const {
+        auto write = [&](std::string_view sv)
+        {
+            return writeAll(*_data.body, sv.data(), sv.size());
+        };
+
+        // Content-Length and the blank line in one write
+        char tail[64];
+        usize n = 0;
+        constexpr std::string_view clPrefix = "Content-Length: ";
+        std::memcpy(tail, clPrefix.data(), clPrefix.size());
+        n += clPrefix.size();
+        n += StringUtils::fast_itoa(tail + n, sizeof(tail) - n - 4, contentLength).size();
+        std::memcpy(tail + n, "\r\n\r\n", 4);
+        n += 4;
+        write(std::string_view(tail, n));
+    }
+
+public:
+    static std::string_view getStatusString(int status) {
         static const std::array<std::string_view, 506> statusMap = []{
             std::array<std::string_view, 506> arr = {};
             arr[100] = "100 Continue";
@@ -140,6 +255,7 @@ private:
             arr[416] = "416 Range Not Satisfiable";
             arr[417] = "417 Expectation Failed";
             arr[429] = "429 Too Many Requests";
+            arr[431] = "431 Request Header Fields Too Large";
             arr[500] = "500 Internal Server Error";
             arr[501] = "501 Not Implemented";
             arr[502] = "502 Bad Gateway";
@@ -156,6 +272,36 @@ private:
 
         return "500 Internal Server Error"; // fallback
     }
+
+private:
+    static void writeHeader(MirrorBuffer& out, HeaderType key, std::string_view value)
+    {
+        writeAll(out, HeaderStrings[key].data(), HeaderStrings[key].size());
+        writeAll(out, ": ", 2);
+        writeAll(out, value.data(), value.size());
+        writeAll(out, "\r\n", 2);
+    }
+
+    /** @brief The worker's pre-serialized head when this response matches one, empty otherwise. */
+    std::string_view cachedHead() const
+    {
+        if (!_heads || _data.version != HTTP_VERSION ||
+            _data.headers[HeaderType::Server] != APP_INFO_HEADER ||
+            !_data.headers[HeaderType::Date].empty())
+            return {};
+
+        std::string_view connection = _data.headers[HeaderType::Connection];
+        bool keepAlive = connection == KEEP_ALIVE_HEADER;
+        if (!keepAlive && connection != CLOSE_CONN_HEADER)
+            return {};
+
+        return _heads->head(_data.status, keepAlive, _data.headers[HeaderType::ContentType]);
+    }
+
+    HttpResponseData _data;
+    ResponseHeadCache* _heads = nullptr;
+    BodyQueue* _bodies = nullptr;
+    ResponseWriter* _writer = nullptr;
 };
 
 #endif // HTTPRESPONSE_H
@@ -0,0 +1,159 @@
+#include "ResponseCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Endpoint/Endpoint.h"
+#include "Response/HttpResponse.h"
+#include "Utils/BumpArena.h"
+#include "Utils/MirrorBuffer.h"
+
+std::string_view ResponseCache::makeKey(std::string_view path, std::string_view query, BumpArena& arena)
+{
+    if (query.empty())
+        return path;
+
+    usize count = std::count(query.begin(), query.end(), '&') + 1;
+    auto* params = static_cast<std::string_view*>(arena.allocate(count * sizeof(std::string_view), alignof(std::string_view)));
+
+    usize n = 0;
+    while (!query.empty())
+    {
+        usize amp = query.find('&');
+        std::string_view param = query.substr(0, amp);
+        if (!param.empty())
+            params[n++] = param;
+        query.remove_prefix(amp == std::string_view::npos ? query.size() : amp + 1);
+    }
+
+    // a=1&b=2 and b=2&a=1 are the same response
+    std::sort(params, params + n);
+
+    usize size = path.size() + 1;
+    for (usize i = 0; i < n; ++i)
+        size += params[i].size() + 1;
+
+    char* key = static_cast<char*>(arena.allocate(size, 1));
+    usize pos = path.size();
+    std::memcpy(key, path.data(), pos);
+    for (usize i = 0; i < n; ++i)
+    {
+        key[pos++] = i == 0 ? '?' : '&';
+        std::memcpy(key + pos, params[i].data(), params[i].size());
+        pos += params[i].size();
+    }
+
+    return std::string_view(key, pos);
+}
+
+bool ResponseCache::serve(const Endpoint& endpoint, std::string_view key, u64 nowMs, std::string_view date, MirrorBuffer& out)
+{
+    RouteCache& route = _routes[&endpoint];
+
+    auto it = route.entries.find(std::hash<std::string_view>{}(key));
+    if (it == route.entries.end() || it->second.key != key)
+    {
+        route.stats.misses++;
+        return false;
+    }
+
+    if (it->second.expiresAt <= nowMs)
+    {
+        erase(route, it);
+        route.stats.misses++;
+        return false;
+    }
+
+    route.stats.hits++;
+
+    const Entry& entry = it->second;
+    if (entry.dateOffset == NO_DATE)
+    {
+        HttpResponse::writeAll(out, entry.bytes.data(), entry.bytes.size());
+        return true;
+    }
+
+    usize dateEnd = entry.dateOffset + date.size();
+    HttpResponse::writeAll(out, entry.bytes.data(), entry.dateOffset);
+    HttpResponse::writeAll(out, date.data(), date.size());
+    HttpResponse::writeAll(out, entry.bytes.data() + dateEnd, entry.bytes.size() - dateEnd);
+    return true;
+}
+
+void ResponseCache::store(const Endpoint& endpoint, std::string_view key, u64 nowMs, const MirrorBuffer& out, usize start)
+{
+    RouteCache& route = _routes[&endpoint];
+    u64 hash = std::hash<std::string_view>{}(key);
+
+    auto it = route.entries.find(hash);
+    if (it != route.entries.end())
+        erase(route, it);
+
+    usize len = out.size() - start;
+    if (len == 0 || !makeRoom(route, endpoint.getCacheBudget(), key.size() + len, nowMs))
+        return;
+
+    Entry entry;
+    entry.key.assign(key);
+    entry.bytes.resize(len);
+    for (usize copied = 0; copied < len; )
+    {
+        usize avail;
+        const char* data = out.peek(start + copied, avail);
+        avail = std::min(avail, len - copied);
+        std::memcpy(entry.bytes.data() + copied, data, avail);
+        copied += avail;
+    }
+
+    // The Date value is swapped for the current one on every hit, the rest is replayed as is
+    entry.dateOffset = NO_DATE;
+    std::string_view bytes(entry.bytes);
+    usize headEnd = bytes.find("\r\n\r\n");
+    usize date = bytes.find("\r\nDate: ");
+    if (date != std::string_view::npos && date < headEnd)
+    {
+        date += 8;
+        if (date + HTTP_DATE_SIZE + 2 <= bytes.size() && bytes.compare(date + HTTP_DATE_SIZE, 2, "\r\n") == 0)
+            entry.dateOffset = date;
+    }
+
+    entry.expiresAt = nowMs + endpoint.getCacheTtl();
+
+    route.stats.bytes += key.size() + len;
+    route.stats.entries++;
+    route.entries.emplace(hash, std::move(entry));
+}
+
+bool ResponseCache::makeRoom(RouteCache& route, usize budget, usize needed, u64 nowMs)
+{
+    if (needed > budget)
+        return false;
+
+    if (route.stats.bytes + needed <= budget)
+        return true;
+
+    for (auto it = route.entries.begin(); it != route.entries.end(); )
+    {
+        auto next = std::next(it);
+        if (it->second.expiresAt <= nowMs)
+            erase(route, it);
+        it = next;
+    }
+
+    // Same TTL for the whole route, the soonest to expire is the oldest
+    while (route.stats.bytes + needed > budget)
+    {
+        auto oldest = std::min_element(route.entries.begin(), route.entries.end(),
+            [](const auto& a, const auto& b) { return a.second.expiresAt < b.second.expiresAt; });
+        erase(route, oldest);
+    }
+
+    return true;
+}
+
+void ResponseCache::erase(RouteCache& route, std::unordered_map<u64, Entry>::iterator it)
+{
+    route.stats.bytes -= it->second.key.size() + it->second.bytes.size();
+    route.stats.entries--;
+    route.entries.erase(it);
+}
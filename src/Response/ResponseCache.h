@@ -0,0 +1,81 @@
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "WarpDefs.h"
+
+class BumpArena;
+class Endpoint;
+class MirrorBuffer;
+
+#define RESPONSE_CACHE_DEFAULT_BUDGET 1024*1024 // Per route and worker
+
+/**
+ * @class ResponseCache
+ * @brief Per-worker shard of serialized responses of endpoints registered with a cache TTL.
+ *
+ * Entries are keyed by endpoint (so method and route) and by the request path plus its
+ * query parameters in sorted order. A hit copies the stored bytes into the write buffer
+ * with only the Date value replaced, the handler does not run. Each route's shard holds
+ * at most its budget of bytes, expired entries go first, then the ones expiring soonest.
+ * Worker thread only: every worker fills its own copy, nothing is locked.
+ */
+class ResponseCache
+{
+public:
+    struct RouteStats {
+        u64 hits = 0;
+        u64 misses = 0;
+        usize bytes = 0;
+        usize entries = 0;
+    };
+
+    /** @brief Path, '?' and the query parameters sorted, in memory from @p arena. */
+    static std::string_view makeKey(std::string_view path, std::string_view query, BumpArena& arena);
+
+    /**
+     * @brief Writes the response stored for @p key, @p date replacing the stored Date value.
+     * @return false on a miss (counted), the handler has to run and store() its response.
+     */
+    bool serve(const Endpoint& endpoint, std::string_view key, u64 nowMs, std::string_view date, MirrorBuffer& out);
+
+    /** @brief Keeps everything @p out received past its first @p start bytes as the response for @p key. */
+    void store(const Endpoint& endpoint, std::string_view key, u64 nowMs, const MirrorBuffer& out, usize start);
+
+    /** @brief Calls @p fn(const Endpoint&, const RouteStats&) for every cached route. */
+    template<typename Fn>
+    void forEachRoute(Fn&& fn) const
+    {
+        for (const auto& [endpoint, route] : _routes)
+            fn(*endpoint, route.stats);
+    }
+
+private:
+    struct Entry {
+        std::string key;
+        std::string bytes;
+        usize dateOffset; // NO_DATE when the response has no Date header to refresh
+        u64 expiresAt;
+    };
+
+    struct RouteCache {
+        std::unordered_map<u64, Entry> entries; // By key hash, a colliding key replaces the entry
+        RouteStats stats;
+    };
+
+    static constexpr usize NO_DATE = ~usize(0);
+
+    /** @brief Evicts until @p needed more bytes fit the route's budget. @return false if they never will. */
+    bool makeRoom(RouteCache& route, usize budget, usize needed, u64 nowMs);
+
+    void erase(RouteCache& route, std::unordered_map<u64, Entry>::iterator it);
+
+    std::unordered_map<const Endpoint*, RouteCache> _routes;
+};
+
+#endif // RESPONSECACHE_H
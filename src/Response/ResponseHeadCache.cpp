@@ -0,0 +1,88 @@
+#include "ResponseHeadCache.h"
+
+#include <cstring>
+
+#include "HttpResponse.h"
+
+ResponseHeadCache::ResponseHeadCache()
+{
+    _date[HTTP_DATE_SIZE] = '\0';
+    refreshDate(time(nullptr));
+}
+
+void ResponseHeadCache::refreshDate(time_t now) noexcept
+{
+    if (now == _dateSecond)
+        return;
+    _dateSecond = now;
+
+    tm utc;
+    gmtime_r(&now, &utc);
+    char buf[HTTP_DATE_SIZE + 1];
+    if (strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &utc) != HTTP_DATE_SIZE)
+        return;
+    std::memcpy(_date, buf, HTTP_DATE_SIZE);
+
+    // Same length every second, the cached heads are patched rather than rebuilt
+    for (u32 i = 0; i < _count; ++i)
+        std::memcpy(_entries[i].bytes + _entries[i].dateOffset, _date, HTTP_DATE_SIZE);
+}
+
+std::string_view ResponseHeadCache::head(i32 status, bool keepAlive, std::string_view contentType) noexcept
+{
+    for (u32 i = 0; i < _count; ++i)
+    {
+        const Entry& entry = _entries[i];
+        if (entry.status == status && entry.keepAlive == keepAlive && entry.contentType() == contentType)
+            return std::string_view(entry.bytes, entry.size);
+    }
+
+    if (_count == RESPONSE_HEAD_CACHE_SIZE)
+        return {};
+
+    Entry& entry = _entries[_count];
+    if (!render(entry, status, keepAlive, contentType))
+        return {};
+
+    _count++;
+    return std::string_view(entry.bytes, entry.size);
+}
+
+bool ResponseHeadCache::render(Entry& entry, i32 status, bool keepAlive, std::string_view contentType) noexcept
+{
+    usize pos = 0;
+    auto append = [&](std::string_view sv) {
+        if (pos + sv.size() > RESPONSE_HEAD_MAX_SIZE)
+            return false;
+        std::memcpy(entry.bytes + pos, sv.data(), sv.size());
+        pos += sv.size();
+        return true;
+    };
+
+    bool fits =
+        append(HTTP_VERSION " ") && append(HttpResponse::getStatusString(status)) &&
+        append("\r\nServer: " APP_INFO_HEADER "\r\nConnection: ") &&
+        append(keepAlive ? KEEP_ALIVE_HEADER : CLOSE_CONN_HEADER) && append("\r\n");
+
+    entry.contentTypeOffset = 0;
+    entry.contentTypeLen = 0;
+    if (fits && !contentType.empty())
+    {
+        fits = append("Content-Type: ");
+        entry.contentTypeOffset = static_cast<u16>(pos);
+        entry.contentTypeLen = static_cast<u16>(contentType.size());
+        fits = fits && append(contentType) && append("\r\n");
+    }
+
+    fits = fits && append("Date: ");
+    entry.dateOffset = static_cast<u16>(pos);
+    fits = fits && append(date()) && append("\r\n");
+
+    if (!fits)
+        return false;
+
+    entry.status = status;
+    entry.keepAlive = keepAlive;
+    entry.size = static_cast<u16>(pos);
+    return true;
+}
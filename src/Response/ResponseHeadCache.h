@@ -0,0 +1,66 @@
+#ifndef RESPONSEHEADCACHE_H
+#define RESPONSEHEADCACHE_H
+
+#pragma once
+
+#include <ctime>
+#include <string_view>
+
+#include "WarpDefs.h"
+
+#define RESPONSE_HEAD_CACHE_SIZE 32
+#define RESPONSE_HEAD_MAX_SIZE 256
+// IMF-fixdate, "Sun, 06 Nov 1994 08:49:37 GMT"
+#define HTTP_DATE_SIZE 29
+
+/**
+ * @class ResponseHeadCache
+ * @brief Per-worker pre-serialized response heads and the current Date header value.
+ *
+ * A head is everything up to and including the Date line for one (status, keep-alive,
+ * Content-Type) combination with the default Server header. Every head stores where its
+ * date sits, so the once-per-second refresh patches them in place instead of dropping
+ * them. Worker thread only.
+ */
+class ResponseHeadCache
+{
+public:
+    ResponseHeadCache();
+
+    /** @brief Re-renders the Date value when @p now is a new second. */
+    void refreshDate(time_t now) noexcept;
+
+    std::string_view date() const noexcept { return std::string_view(_date, HTTP_DATE_SIZE); }
+
+    /**
+     * @param contentType Empty for no Content-Type line.
+     * @return The head, empty if it cannot be cached (full, or an unusually long Content-Type).
+     */
+    std::string_view head(i32 status, bool keepAlive, std::string_view contentType) noexcept;
+
+private:
+    struct Entry {
+        i32 status;
+        bool keepAlive;
+        u16 contentTypeOffset;
+        u16 contentTypeLen;
+        u16 dateOffset;
+        u16 size;
+        char bytes[RESPONSE_HEAD_MAX_SIZE];
+
+        std::string_view contentType() const noexcept
+        {
+            return std::string_view(bytes + contentTypeOffset, contentTypeLen);
+        }
+    };
+
+    bool render(Entry& entry, i32 status, bool keepAlive, std::string_view contentType) noexcept;
+
+    Entry _entries[RESPONSE_HEAD_CACHE_SIZE];
+    u32 _count = 0;
+
+    time_t _dateSecond = 0;
+    char _date[HTTP_DATE_SIZE + 1];
+};
+
+#endif // RESPONSEHEADCACHE_H
@@ -0,0 +1,66 @@
+#include "ResponseWriter.h"
+
+#include <charconv>
+#include <exception>
+
+#include "HttpResponse.h"
+
+bool ResponseWriter::write(std::string_view data)
+{
+    if (!_out || data.empty())
+        return _out != nullptr;
+
+    if (!_chunked)
+        return HttpResponse::writeAll(*_out, data.data(), data.size());
+
+    // Size line, payload and CRLF
+    char sizeLine[24];
+    char* end = std::to_chars(sizeLine, sizeLine + sizeof(sizeLine) - 2, data.size(), 16).ptr;
+    end[0] = '\r';
+    end[1] = '\n';
+
+    return HttpResponse::writeAll(*_out, sizeLine, end + 2 - sizeLine) &&
+           HttpResponse::writeAll(*_out, data.data(), data.size()) &&
+           HttpResponse::writeAll(*_out, "\r\n", 2);
+}
+
+void ResponseWriter::end()
+{
+    if (!_out)
+        return;
+
+    if (_chunked)
+        HttpResponse::writeAll(*_out, "0\r\n\r\n", 5);
+    _out = nullptr;
+    _next = nullptr;
+}
+
+bool ResponseWriter::resume()
+{
+    // Held here while it runs, it may end the stream or replace itself
+    Continuation next = std::move(_next);
+    _next = nullptr;
+
+    try
+    {
+        bool more = next(*this);
+        if (!more)
+            end();
+        else if (_out && !_next)
+            _next = std::move(next);
+    }
+    catch (const std::exception& e)
+    {
+        INK_ERROR << "Response stream failed: " << e.what();
+        abort();
+        return false;
+    }
+
+    return true;
+}
+
+void ResponseWriter::abort() noexcept
+{
+    _out = nullptr;
+    _next = nullptr;
+}
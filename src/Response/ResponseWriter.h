@@ -0,0 +1,81 @@
+#ifndef RESPONSEWRITER_H
+#define RESPONSEWRITER_H
+
+#pragma once
+
+#include <functional>
+#include <string_view>
+
+#include "WarpDefs.h"
+
+class MirrorBuffer;
+
+/**
+ * @class ResponseWriter
+ * @brief Chunked response body written piece by piece, obtained from HttpResponse::stream().
+ *
+ * HTTP/1.0 clients know no chunked coding: their body goes out as written and ends with
+ * the connection.
+ *
+ * A handler can write a few chunks and return, the body is ended for it. To produce more
+ * than it wants to hold at once it registers a continuation with onWritable(): the session
+ * then keeps the stream open, sends what is queued and calls the continuation each time
+ * the queued output drained below half of max_response_size. No other request of the
+ * connection is handled meanwhile. One per Session, worker thread only.
+ */
+class ResponseWriter
+{
+public:
+    /**
+     * @brief Produces the next piece of the body.
+     * @return true to be called again once the output drained, false when the body is complete.
+     * @note Runs after the handler returned: the request is gone, capture copies of what it needs.
+     */
+    using Continuation = std::function<bool(ResponseWriter&)>;
+
+    ResponseWriter() = default;
+
+    ResponseWriter(const ResponseWriter&) = delete;
+    ResponseWriter& operator=(const ResponseWriter&) = delete;
+
+    /** @brief Queues @p data as one chunk, empty data is skipped. @return false if the write buffer dropped it. */
+    bool write(std::string_view data);
+
+    /** @brief Keeps the stream open after the handler returns and hands the rest of the body to @p next. */
+    void onWritable(Continuation next) { _next = std::move(next); }
+
+    /** @brief Writes the terminating chunk, if any. Later writes are ignored. */
+    void end();
+
+    bool isOpen() const noexcept { return _out != nullptr; }
+
+    /** @brief False for HTTP/1.0 requests, whose body is delimited by closing the connection. */
+    bool isChunked() const noexcept { return _chunked; }
+
+    /** @brief Open with a continuation waiting for the output to drain. */
+    bool isWaiting() const noexcept { return _out && _next; }
+
+private:
+    friend class HttpResponse;
+    friend class Session;
+
+    void begin(MirrorBuffer& out) noexcept { _out = &out; }
+
+    /** @brief Framing of the next stream, set by the session from the request version. */
+    void setChunked(bool chunked) noexcept { _chunked = chunked; }
+
+    /**
+     * @brief Runs the continuation once, ending the body when it reports completion.
+     * @return false if the continuation threw: the stream is abandoned without its terminator.
+     */
+    bool resume();
+
+    /** @brief Abandons the stream, the connection must be closed since the body is unterminated. */
+    void abort() noexcept;
+
+    MirrorBuffer* _out = nullptr; // Set while open
+    Continuation _next;
+    bool _chunked = true;
+};
+
+#endif // RESPONSEWRITER_H
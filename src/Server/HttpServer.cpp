@@ -48,3 +48,13 @@ void HttpServer::stop()
 
     INK_INFO << "Server stopped";
 }
+
+bool HttpServer::post(u32 workerIdx, WorkerTask task)
+{
+    return _eventLoop->post(workerIdx, std::move(task));
+}
+
+u32 HttpServer::broadcast(const WorkerTask& task)
+{
+    return _eventLoop->broadcast(task);
+}
@@ -15,6 +15,12 @@ public:
     void start();
     void stop();
 
+    /** @brief Runs @p task on worker @p workerIdx's thread, see EventLoop::post. */
+    bool post(u32 workerIdx, WorkerTask task);
+
+    /** @brief Runs a copy of @p task on every worker's thread. */
+    u32 broadcast(const WorkerTask& task);
+
 private:
     bool _running;
 
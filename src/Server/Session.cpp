@@ -9,36 +9,26 @@
 #include "WebSocket.h"
 #include "WebSocketContext.h"
 #include "EventLoop/EventLoop.h"
+#include "EventLoop/ProvidedBufferRing.h"
+#include "EventLoop/WorkerContext.h"
 #include "Managers/EndpointManager.h"
 #include "Response/HttpResponse.h"
 #include "Utils/HeadersList.h"
 #include "Utils/StringUtils.h"
 #include "Settings/Settings.h"
 
-#ifdef USE_IOURING
-Session::Session(socket_t socket) :
+Session::Session(socket_t socket, WorkerContext* worker) :
     _socket(socket),
-    _req(),
+    _arena(REQUEST_ARENA_BLOCK_SIZE, &worker->arenaTotals),
+    _req(_arena),
     _keepAlive(false),
-    _readBuffer(Settings::getSettings().max_request_size),
-    _writeBuffer(Settings::getSettings().max_response_size)
+    _readBuffer(worker->bufRing ? nullptr : std::make_unique<MirrorBuffer>(worker->buffers, Settings::getSettings().max_request_size)),
+    _writeBuffer(worker->buffers, Settings::getSettings().max_response_size,
+                 &worker->overflowBlocks, Settings::getSettings().max_response_overflow),
+    _worker(worker)
 {
     // Empty
 }
-#endif
-
-#ifdef USE_EPOLL
-Session::Session(socket_t socket, socket_t assignedEpollFd) :
-    _socket(socket),
-    _req(),
-    _keepAlive(false),
-    _readBuffer(Settings::getSettings().max_request_size),
-    _writeBuffer(Settings::getSettings().max_response_size),
-    _assignedEpollFd(assignedEpollFd)
-{
-    // Empty
-}
-#endif
 
 Session::~Session()
 {
@@ -49,14 +39,40 @@ void Session::close()
 {
     if (_socket == SOCKET_ERROR_VALUE) return;
 
+    if (_worker->directFds)
+    {
+        // The slot only exists inside the ring, in-flight ops keep their own reference
+        io_uring_sqe* sqe = _worker->getSqe();
+        if (sqe)
+        {
+            io_uring_prep_close_direct(sqe, _socket);
+            io_uring_sqe_set_data(sqe, nullptr);
+        }
+        _socket = SOCKET_ERROR_VALUE;
+        return;
+    }
+
     ::close(_socket);
     _socket = SOCKET_ERROR_VALUE;
 }
 
 void Session::shutdown()
 {
-    if (_socket > SOCKET_ERROR_VALUE)
-        ::shutdown(_socket, SHUT_RDWR);
+    if (_socket <= SOCKET_ERROR_VALUE) return;
+
+    if (_worker->directFds)
+    {
+        io_uring_sqe* sqe = _worker->getSqe();
+        if (sqe)
+        {
+            io_uring_prep_shutdown(sqe, _socket, SHUT_RDWR);
+            sqe->flags |= IOSQE_FIXED_FILE;
+            io_uring_sqe_set_data(sqe, nullptr);
+        }
+        return;
+    }
+
+    ::shutdown(_socket, SHUT_RDWR);
 }
 
 socket_t Session::getSocket() const noexcept
@@ -64,45 +80,86 @@ socket_t Session::getSocket() const noexcept
     return _socket;
 }
 
+i32 Session::incomingCpu() const noexcept
+{
+    if (_socket == SOCKET_ERROR_VALUE || _worker->directFds)
+        return -1;
+
+    int cpu = -1;
+    socklen_t len = sizeof(cpu);
+    if (getsockopt(_socket, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &len) < 0)
+        return -1;
+
+    return cpu;
+}
+
 void Session::wsFrameSend(u8 opcode, std::string_view payload, bool fin)
 {
     ws::sendFrame(_writeBuffer, opcode, payload, fin);
 }
 
-#ifdef USE_EPOLL
 socket_t Session::getAssignedEpollFd() const noexcept
 {
-    return _assignedEpollFd;
+    return _worker->epollFd;
 }
 
 bool Session::onReadReady()
 {
+    const SettingsData& settings = Settings::getSettings();
+
+    // This turn's share of the worker, whatever is left waits for the next round
+    _requestBudget = settings.session_request_budget;
+    usize byteBudget = settings.session_read_budget;
+    _inputPending = false;
+
     int read = false;
+
+    // Pipelined requests an earlier turn left in the buffer go before reading more
+    if (_mode == ProtocolMode::Http && _readBuffer->size() > 0)
+    {
+        processHttpBuffer();
+        if (pendingOutput() > 0)
+            onWriteReady();
+
+        if (_socket == SOCKET_ERROR_VALUE)
+            return true;
+    }
+
     while (1)
     {
+        // Left in the socket until the streamed response ended, see pumpStream()
+        if (_stream.isOpen())
+            break;
+
+        if (_requestBudget == 0 || byteBudget == 0)
+        {
+            _inputPending = true;
+            break;
+        }
+
         size_t availableSpace;
-        char* buf = _readBuffer.getWriteBuffer(availableSpace);
+        char* buf = _readBuffer->getWriteBuffer(availableSpace);
         if (availableSpace == 0)
         {
             close();
             return true;
         }
 
-        ssize_t bytesRead = recv(_socket, buf, availableSpace, 0);
+        ssize_t bytesRead = recv(_socket, buf, std::min(availableSpace, byteBudget), 0);
         if (bytesRead > 0)
         {
             read = true;
-            _readBuffer.advanceWritePos(bytesRead);
+            byteBudget -= bytesRead;
+            _readBuffer->advanceWritePos(bytesRead);
 
             if (_mode == ProtocolMode::Http)
             {
-                while (parseRequest())
-                    handleRequest();
+                processHttpBuffer();
             }
             else
             {
                 WebSocketContext ctx(*this);
-                if (!ws::processFrames(_wsState, ctx, _readBuffer, _writeBuffer))
+                if (!ws::processFrames(_wsState, ctx, *_readBuffer, _writeBuffer))
                 {
                     _keepAlive = false;
                     close();
@@ -111,12 +168,12 @@ bool Session::onReadReady()
             }
 
             // Flush writes immediately without waiting for EPOLLOUT
-            if (_writeBuffer.size() > 0)
+            if (pendingOutput() > 0)
             {
                 onWriteReady();
 
                 // If onWriteReady hit EAGAIN, stop reading to avoid memory bloat
-                if (_writeBuffer.size() > 0)
+                if (pendingOutput() > 0)
                     break;
             }
         }
@@ -139,24 +196,49 @@ bool Session::onReadReady()
 
 bool Session::onWriteReady()
 {
-    if (_writeBuffer.size() == 0)
+    if (pendingOutput() == 0 && !_stream.isWaiting())
         return false;
 
+    if (isWriteTruncated())
+    {
+        close();
+        return true;
+    }
+
     bool wrote = false;
 
     while (1)
     {
-        size_t available;
-        const char* readBuf = _writeBuffer.getReadBuffer(available);
+        pumpStream();
 
-        if (available == 0) break;
+        ssize_t bytesSent;
+        if (_bodies.empty() && !_writeBuffer.isSegmented())
+        {
+            size_t available;
+            const char* readBuf = _writeBuffer.getReadBuffer(available);
+
+            if (available == 0) break;
+
+            bytesSent = send(_socket, readBuf, available, 0);
+        }
+        else
+        {
+            // Heads from the write buffer and its overflow segments, bodies from wherever they live
+            msghdr msg{};
+            iovec iov[SEND_IOV_MAX];
+            usize available;
+            msg.msg_iov = iov;
+            msg.msg_iovlen = _bodies.gather(_writeBuffer, iov, available);
+
+            if (available == 0) break;
 
-        ssize_t bytesSent = send(_socket, readBuf, available, 0);
+            bytesSent = sendmsg(_socket, &msg, 0);
+        }
 
         if (bytesSent > 0)
         {
             wrote = true;
-            _writeBuffer.advanceReadPos(bytesSent);
+            _bodies.consume(_writeBuffer, bytesSent);
         }
         else
         {
@@ -167,7 +249,7 @@ bool Session::onWriteReady()
         }
     }
 
-    if (_writeBuffer.size() == 0)
+    if (pendingOutput() == 0)
         onWriteComplete();
 
     return wrote;
@@ -175,23 +257,73 @@ bool Session::onWriteReady()
 
 void Session::onWriteComplete()
 {
-    if (_keepAlive)
-    {
-        if (_mode == ProtocolMode::Http)
-            _req.reset();
-    }
-    else
-    {
+    // _req is reset by the parser when the next request starts, it may already hold part of it
+    if (!_keepAlive && !_stream.isOpen())
         close();
+}
+
+void Session::pumpStream()
+{
+    if (!_stream.isWaiting())
+        return;
+
+    usize lowWater = Settings::getSettings().max_response_size / 2;
+    while (_stream.isWaiting() && pendingOutput() < lowWater)
+    {
+        usize before = pendingOutput();
+        if (!_stream.resume())
+        {
+            // The body can't be terminated anymore, the client only learns through the close
+            _keepAlive = false;
+            setStatus(SessionStatus::Closing);
+            return;
+        }
+
+        // Nothing would ever drain to call it again
+        if (_stream.isWaiting() && pendingOutput() == before)
+        {
+            INK_WARN << "Response stream continuation wrote nothing, ending the body.";
+            _stream.end();
+        }
     }
+
+    if (_stream.isOpen())
+        return;
+
+    releaseRequestMemory();
+
+    // Epoll reads were held back, give the session a read turn for what the client sent meanwhile
+    if (_worker->backend == IoBackend::Epoll)
+        _inputPending = true;
 }
-#endif
 
-#ifdef USE_IOURING
 void Session::onReadReady(io_uring_sqe* sqe)
 {
+    if (_worker->bufRing && !_readBuffer)
+    {
+        // Nothing buffered: let the kernel pick a buffer when bytes actually arrive
+        if (Settings::getSettings().multishot_recv)
+            io_uring_prep_recv_multishot(sqe, _socket, nullptr, 0, 0);
+        else
+            io_uring_prep_recv(sqe, _socket, nullptr, 0, 0);
+        sqe->flags |= IOSQE_BUFFER_SELECT | fixedFileFlag();
+        sqe->buf_group = _worker->bufRing->groupId();
+        io_uring_sqe_set_data(sqe, &_readReq);
+        updateIoState(IO_READING, true);
+        return;
+    }
+
     size_t availableSpace;
-    char* buf = _readBuffer.getWriteBuffer(availableSpace);
+    char* buf = _readBuffer->getWriteBuffer(availableSpace);
+
+    if (availableSpace == 0 && _readBuffer->isPinned())
+    {
+        // Bodies being sent in place hold the space, completeWrite() resumes once they went out
+        _readPaused = true;
+        io_uring_prep_nop(sqe);
+        io_uring_sqe_set_data(sqe, nullptr);
+        return;
+    }
 
     if (availableSpace == 0)
     {
@@ -202,15 +334,28 @@ void Session::onReadReady(io_uring_sqe* sqe)
     }
 
     io_uring_prep_recv(sqe, _socket, buf, availableSpace, 0);
+    sqe->flags |= fixedFileFlag();
     io_uring_sqe_set_data(sqe, &_readReq);
     updateIoState(IO_READING, true);
 }
 
+void Session::cancelRead(io_uring_sqe* sqe)
+{
+    io_uring_prep_cancel64(sqe, reinterpret_cast<u64>(&_readReq), 0);
+    io_uring_sqe_set_data(sqe, nullptr);
+}
+
 void Session::onWriteReady(io_uring_sqe* sqe)
 {
+    if (!_bodies.empty() || _writeBuffer.isSegmented())
+    {
+        sendGathered(sqe);
+        return;
+    }
+
     size_t availableSpace;
     const char* readBuf = _writeBuffer.getReadBuffer(availableSpace);
-    if (availableSpace == 0)
+    if (availableSpace == 0 || isWriteTruncated())
     {
         this->close();
         io_uring_prep_nop(sqe);
@@ -220,18 +365,80 @@ void Session::onWriteReady(io_uring_sqe* sqe)
 
     // MSG_NOSIGNAL prevents EPIPE from killing the process
     // if the client closed the connection.
-    io_uring_prep_send_zc(sqe, _socket, readBuf, availableSpace, MSG_NOSIGNAL, 0);
+    // Small writes are cheaper copied: send_zc costs an extra F_NOTIF CQE
+    // and keeps the buffer pinned until the NIC is done with it.
+    if (availableSpace < Settings::getSettings().zerocopy_send_threshold)
+    {
+        io_uring_prep_send(sqe, _socket, readBuf, availableSpace, MSG_NOSIGNAL);
+        _worker->stats.plainSends++;
+    }
+    else
+    {
+        io_uring_prep_send_zc(sqe, _socket, readBuf, availableSpace, MSG_NOSIGNAL, 0);
+        _worker->stats.zeroCopySends++;
+    }
+    sqe->flags |= fixedFileFlag();
+    io_uring_sqe_set_data(sqe, &_writeReq);
+    updateIoState(IO_WRITING, true);
+}
+
+void Session::sendGathered(io_uring_sqe* sqe)
+{
+    msghdr& msg = _bodies.message();
+    usize available;
+    msg = msghdr{};
+    msg.msg_iov = _bodies.iovecs();
+    msg.msg_iovlen = _bodies.gather(_writeBuffer, msg.msg_iov, available);
+
+    if (available == 0 || isWriteTruncated())
+    {
+        this->close();
+        io_uring_prep_nop(sqe);
+        io_uring_sqe_set_data(sqe, nullptr);
+        return;
+    }
+
+    if (!_worker->sendmsgZc || available < Settings::getSettings().zerocopy_send_threshold)
+    {
+        io_uring_prep_sendmsg(sqe, _socket, &msg, MSG_NOSIGNAL);
+        _worker->stats.plainSends++;
+    }
+    else
+    {
+        // The owners keep the bodies alive until the F_NOTIF CQE releases them in completeWrite()
+        io_uring_prep_sendmsg_zc(sqe, _socket, &msg, MSG_NOSIGNAL);
+        _worker->stats.zeroCopySends++;
+    }
+    sqe->flags |= fixedFileFlag();
     io_uring_sqe_set_data(sqe, &_writeReq);
     updateIoState(IO_WRITING, true);
 }
 
-bool Session::processRead(i32 bytesRecv, io_uring* ring)
+bool Session::processRead(i32 bytesRecv, u32 cqeFlags, io_uring* ring)
 {
-    updateIoState(IO_READING, false);
+    // A multishot recv stays armed until the kernel posts a CQE without F_MORE
+    if (!(cqeFlags & IORING_CQE_F_MORE))
+        updateIoState(IO_READING, false);
 
-    if (bytesRecv <= 0)
+    if (bytesRecv == -ECANCELED)
+    {
+        // Cancelled for backpressure, resumeRead() re-arms it. Unless it already ran while
+        // this recv was still in flight and skipped the re-arm: that is left to the bottom
+        if (_readPaused || _status != SessionStatus::Active)
+            return true;
+    }
+    else if (bytesRecv == -ENOBUFS)
     {
-        if (_writeBuffer.size() == 0) {
+        // Buffer ring ran dry: the re-arm below receives straight into a private buffer, kept
+        // until a request went through it. A multishot recv may already have staged a partial
+        // request there, keep it
+        if (!_readBuffer)
+            _readBuffer = std::make_unique<MirrorBuffer>(_worker->buffers, Settings::getSettings().max_request_size);
+        _fallbackRead = true;
+    }
+    else if (bytesRecv <= 0)
+    {
+        if (pendingOutput() == 0) {
             this->close();
             return false;
         }
@@ -239,30 +446,54 @@ bool Session::processRead(i32 bytesRecv, io_uring* ring)
         setStatus(SessionStatus::Closing);
         return true;
     }
+    else if (cqeFlags & IORING_CQE_F_BUFFER)
+    {
+        u16 bid = static_cast<u16>(cqeFlags >> IORING_CQE_BUFFER_SHIFT);
+        _inPlace.data = _worker->bufRing->buffer(bid);
+        _inPlace.len = static_cast<usize>(bytesRecv);
+        _inPlace.bid = bid;
 
-    _readBuffer.advanceWritePos(bytesRecv);
+        bool fits = consumeProvidedBuffer(_inPlace.data, _inPlace.len);
 
-    if (_mode == ProtocolMode::Http)
-    {
-        while (parseRequest())
-            handleRequest();
+        // A body still being sent from the buffer recycles it once it went out
+        if (!_inPlace.pin)
+            _worker->bufRing->recycle(bid);
+        _inPlace = InPlaceRead{};
+
+        if (!fits)
+        {
+            this->close();
+            return false;
+        }
     }
     else
     {
-        WebSocketContext ctx(*this);
-        if (!ws::processFrames(_wsState, ctx, _readBuffer, _writeBuffer))
-        {
-            setStatus(SessionStatus::Closing);
-            _keepAlive = false;
-        }
+        _readBuffer->advanceWritePos(bytesRecv);
+        if (!_readPaused)
+            drainReadBuffer();
     }
 
-    if (_writeBuffer.size() > 0 && !isWriteInFlight())
+    releaseReadBuffer();
+
+    // A zerocopy send waiting for its F_NOTIF still owns the front of the output, completeWrite() goes on from there
+    if (pendingOutput() > 0 && !isWriteInFlight() && !isZcNotifInFlight())
     {
         io_uring_sqe* wSqe = io_uring_get_sqe(ring);
         if (wSqe) onWriteReady(wSqe);
     }
 
+    if (isWriteBackpressured())
+    {
+        // Stop pulling requests off the socket until the client drains what it already owes us
+        if (!_readPaused && isReadInFlight())
+        {
+            io_uring_sqe* cSqe = io_uring_get_sqe(ring);
+            if (cSqe) cancelRead(cSqe);
+        }
+        _readPaused = true;
+        return true;
+    }
+
     if (!isReadInFlight() && _status == SessionStatus::Active)
     {
         io_uring_sqe* rSqe = io_uring_get_sqe(ring);
@@ -272,30 +503,122 @@ bool Session::processRead(i32 bytesRecv, io_uring* ring)
     return true;
 }
 
-bool Session::processWrite(i32 bytesSent, bool is_notif, io_uring* ring)
+bool Session::isWriteTruncated()
 {
-    if (is_notif)
+    if (!_writeBuffer.truncated())
+        return false;
+
+    // Part of a response was dropped, what is queued can no longer be framed correctly
+    if (_socket != SOCKET_ERROR_VALUE)
     {
-        // Zero-Copy Notification (CQE 2): NIC is done with memory, advance buffer now
-        updateIoState(IO_WAITING_ZC, false);
+        INK_WARN << "Response exceeded the write buffer overflow limit, closing the connection.";
+        _worker->stats.overflowCloses++;
+    }
+    return true;
+}
 
-        _writeBuffer.advanceReadPos(_lockedZcBytes);
-        _lockedZcBytes = 0;
+u8 Session::fixedFileFlag() const noexcept
+{
+    return _worker->directFds ? IOSQE_FIXED_FILE : 0;
+}
 
-        if (_writeBuffer.size() > 0)
-        {
-            io_uring_sqe* wSqe = io_uring_get_sqe(ring);
-            if (wSqe) onWriteReady(wSqe);
+bool Session::isWriteBackpressured() const
+{
+    return _stream.isOpen() || pendingOutput() >= Settings::getSettings().max_response_size / 2;
+}
+
+void Session::resumeRead(io_uring* ring)
+{
+    _readPaused = false;
+
+    if (_readBuffer && _readBuffer->size() > 0)
+        drainReadBuffer();
+
+    releaseReadBuffer();
+
+    // The staged requests alone may have refilled the write side
+    if (isWriteBackpressured())
+    {
+        _readPaused = true;
+        return;
+    }
+
+    if (!isReadInFlight() && _status == SessionStatus::Active)
+    {
+        io_uring_sqe* rSqe = io_uring_get_sqe(ring);
+        if (rSqe) onReadReady(rSqe);
+    }
+}
+
+bool Session::consumeProvidedBuffer(const char* data, usize len)
+{
+    usize offset = 0;
+
+    // Fast path: nothing pending, so complete requests are parsed straight out of the kernel buffer
+    if (!_readBuffer && !_readPaused && _mode == ProtocolMode::Http)
+    {
+        offset = processHttp(data, len);
+        if (offset == len)
             return true;
-        }
+    }
 
-        if (!_keepAlive)
+    if (!_readBuffer)
+        _readBuffer = std::make_unique<MirrorBuffer>(_worker->buffers, Settings::getSettings().max_request_size);
+
+    if (!HttpResponse::writeAll(*_readBuffer, data + offset, len - offset))
+        return false;
+
+    if (!_readPaused)
+        processReadBuffer();
+    return true;
+}
+
+void Session::drainReadBuffer()
+{
+    processReadBuffer();
+
+    // A request went through the private buffer, the ring had time to refill meanwhile
+    if (_readBuffer->size() == 0)
+        _fallbackRead = false;
+}
+
+void Session::releaseReadBuffer()
+{
+    // Give the private buffer back once it no longer holds a partial request, unless
+    // the ring ran dry: that would only arm another buffer-select recv against it.
+    // Bodies still sent out of it keep it too
+    if (_worker->bufRing && _readBuffer && _readBuffer->size() == 0 && !_fallbackRead && !_readBuffer->isPinned())
+        _readBuffer.reset();
+}
+
+void Session::processReadBuffer()
+{
+    if (_mode == ProtocolMode::Http)
+    {
+        processHttpBuffer();
+    }
+    else
+    {
+        WebSocketContext ctx(*this);
+        if (!ws::processFrames(_wsState, ctx, *_readBuffer, _writeBuffer))
         {
-            this->close();
-            return false;
+            setStatus(SessionStatus::Closing);
+            _keepAlive = false;
         }
+    }
+}
 
-        return true;
+bool Session::processWrite(i32 bytesSent, bool is_notif, io_uring* ring)
+{
+    if (is_notif)
+    {
+        // Zero-Copy Notification (CQE 2): NIC is done with memory, advance buffer now
+        updateIoState(IO_WAITING_ZC, false);
+
+        usize released = _lockedZcBytes;
+        _lockedZcBytes = 0;
+
+        return completeWrite(released, ring);
     }
 
     // Send Result (CQE 1)
@@ -307,159 +630,560 @@ bool Session::processWrite(i32 bytesSent, bool is_notif, io_uring* ring)
         return false;
     }
 
+    // Plain send: the kernel already copied the bytes, nothing stays pinned
+    if (!isZcNotifInFlight())
+        return completeWrite(bytesSent, ring);
+
     // Record how many bytes the kernel accepted but DO NOT advance the buffer yet.
     // The memory is still pinned by the NIC until the F_NOTIF CQE arrives.
     _lockedZcBytes = bytesSent;
 
     return true;
 }
-#endif
 
-bool Session::parseRequest()
+bool Session::completeWrite(usize bytesSent, io_uring* ring)
 {
-    size_t avail;
-    const char* data = _readBuffer.getReadBuffer(avail);
-    if (__builtin_expect(!data || avail < MIN_REQUEST_SIZE, 0))
-        return false;
+    _bodies.consume(_writeBuffer, bytesSent);
+    pumpStream();
 
-    const char* p = data;
-    const char* end = data + avail;
+    if (_readPaused && !isWriteBackpressured())
+        resumeRead(ring);
 
-    // REQUEST LINE
-    const char* lineEnd = StringUtils::find_crlf(p, end);
-    if (__builtin_expect(!lineEnd || lineEnd + 1 >= end || lineEnd[1] != '\n', 0))
+    if (pendingOutput() > 0)
+    {
+        io_uring_sqe* wSqe = io_uring_get_sqe(ring);
+        if (wSqe) onWriteReady(wSqe);
+        return true;
+    }
+
+    if (!_keepAlive)
+    {
+        this->close();
         return false;
+    }
+
+    return true;
+}
 
-    // METHOD
-    const char* methodEnd = p;
-    while (methodEnd < lineEnd && *methodEnd != ' ') ++methodEnd;
-    if (__builtin_expect(methodEnd == lineEnd, 0)) return false;
+void Session::processHttpBuffer()
+{
+    while (_mode == ProtocolMode::Http)
+    {
+        size_t avail;
+        const char* data = _readBuffer->getReadBuffer(avail);
 
-    std::string_view method(p, methodEnd - p);
+        usize consumed = processHttp(data, avail);
+        if (consumed == 0)
+            return;
 
-    // PATH
-    const char* pathStart = methodEnd + 1;
-    const char* pathEnd = pathStart;
-    while (pathEnd < lineEnd && *pathEnd != '?' && *pathEnd != ' ') ++pathEnd;
-    if (__builtin_expect(pathEnd == lineEnd, 0)) return false;
+        _readBuffer->advanceReadPos(consumed);
+    }
+}
 
-    std::string_view path(pathStart, pathEnd - pathStart);
+usize Session::processHttp(const char* data, usize avail)
+{
+    usize offset = 0;
 
-    const char* queryStart = nullptr;
-    const char* queryEnd = nullptr;
-    if (*pathEnd == '?')
+    while (_mode == ProtocolMode::Http && offset < avail && _socket != SOCKET_ERROR_VALUE)
     {
-        queryStart = pathEnd + 1;
-        queryEnd = queryStart;
-        while (queryEnd < lineEnd && *queryEnd != ' ') ++queryEnd;
-        if (__builtin_expect(queryEnd == lineEnd, 0)) return false;
+        // Responses go out in order, the next request waits for the streamed one to end
+        if (_stream.isOpen())
+            break;
+
+        if (_body.endpoint)
+        {
+            usize consumed = feedBody(data + offset, avail - offset);
+            if (consumed == 0)
+                break;
+
+            offset += consumed;
+            continue;
+        }
+
+        if (_requestBudget == 0)
+            break;
+
+        usize consumed = parseRequest(data + offset, avail - offset);
+        if (consumed == 0)
+            break;
+
+        offset += consumed;
+
+        // Only the head was consumed, the body follows through feedBody()
+        if (!_body.endpoint)
+        {
+            handleRequest();
+            if (_requestBudget != NO_REQUEST_BUDGET)
+                --_requestBudget;
+        }
     }
-    else
+
+    return offset;
+}
+
+usize Session::parseRequest(const char* data, usize avail)
+{
+    if (__builtin_expect(!data, 0))
+        return 0;
+
+    ParseState& st = _parse;
+
+    if (__builtin_expect(st.stage == ParseState::Stage::Invalid, 0))
+        return 0;
+
+    auto reject = [&](StatusCode status, std::string_view message) -> usize {
+        st.stage = ParseState::Stage::Invalid;
+        rejectRequest(status, message);
+        return 0;
+    };
+
+    if (!st.base)
     {
-        queryStart = pathEnd;
-        queryEnd = pathEnd;
+        st.base = data;
+        _req.reset();
+    }
+    else if (st.base != data)
+    {
+        // The partial request was staged into another buffer, views already stored in _req
+        // would dangle. It may also be de-chunked in place already, so it cannot be re-parsed
+        _req.relocate(st.base, data, st.offset);
+        st.base = data;
     }
 
-    std::string_view query(queryStart, queryEnd - queryStart);
+    const char* end = data + avail;
 
-    // VERSION
-    const char* verStart = queryEnd + 1;
-    std::string_view version(verStart, lineEnd - verStart);
+    // REQUEST LINE
+    if (st.stage == ParseState::Stage::RequestLine)
+    {
+        if (__builtin_expect(avail < MIN_REQUEST_SIZE, 0))
+            return 0;
 
-    _req.setMethod(HttpRequest::parseMethod(method));
-    _req.setPath(path, query);
-    _req.setVersion(version);
+        const char* p = data;
+        const char* lineEnd = StringUtils::find_crlf(data + st.scanned, end);
+        if (!lineEnd)
+        {
+            st.scanned = avail;
+            return 0;
+        }
+        if (lineEnd + 1 >= end)
+        {
+            st.scanned = lineEnd - data;
+            return 0;
+        }
+        if (__builtin_expect(lineEnd[1] != '\n', 0))
+            return reject(StatusCode::bad_request, "Malformed request line.");
 
-    p = lineEnd + 2; // skip CRLF
+        // METHOD
+        const char* methodEnd = StringUtils::find_char(p, lineEnd, ' ');
+        if (__builtin_expect(!methodEnd || methodEnd == p, 0))
+            return reject(StatusCode::bad_request, "Malformed request line.");
 
-    // HEADERS
-    size_t contentLength = 0;
-    bool hasContentLen = false;
-    _keepAlive = true; // HTTP/1.1 default
+        std::string_view method(p, methodEnd - p);
 
-    while (__builtin_expect(p < end, 1))
-    {
-        if (__builtin_expect(p + 1 < end && p[0] == '\r' && p[1] == '\n', 0))
+        // PATH
+        const char* pathStart = methodEnd + 1;
+        const char* pathEnd = StringUtils::find_either(pathStart, lineEnd, '?', ' ');
+        if (__builtin_expect(!pathEnd, 0))
+            return reject(StatusCode::bad_request, "Malformed request line.");
+
+        std::string_view path(pathStart, pathEnd - pathStart);
+
+        const char* queryStart = nullptr;
+        const char* queryEnd = nullptr;
+        if (*pathEnd == '?')
         {
-            p += 2;
-            break;
+            queryStart = pathEnd + 1;
+            queryEnd = StringUtils::find_char(queryStart, lineEnd, ' ');
+            if (__builtin_expect(!queryEnd, 0))
+                return reject(StatusCode::bad_request, "Malformed request line.");
+        }
+        else
+        {
+            queryStart = pathEnd;
+            queryEnd = pathEnd;
         }
 
-        const char* hEnd = StringUtils::find_crlf(p, end);
-        if (__builtin_expect(!hEnd || hEnd + 1 >= end || hEnd[1] != '\n', 0))
-            return false;
+        std::string_view query(queryStart, queryEnd - queryStart);
+
+        // VERSION
+        const char* verStart = queryEnd + 1;
+        std::string_view version(verStart, lineEnd - verStart);
+
+        _req.setMethod(HttpRequest::parseMethod(method));
+        _req.setPath(path, query);
+        _req.setVersion(version);
+
+        _keepAlive = true; // HTTP/1.1 default
 
-        const char* colon = p;
-        while (colon < hEnd && *colon != ':') ++colon;
+        st.offset = (lineEnd + 2) - data; // skip CRLF
+        st.scanned = st.offset;
+        st.stage = ParseState::Stage::Headers;
+    }
+
+    // HEADERS
+    if (st.stage == ParseState::Stage::Headers)
+    {
+        const char* p = data + st.offset;
 
-        if (colon == hEnd)
+        while (__builtin_expect(p < end, 1))
         {
+            if (__builtin_expect(p + 1 < end && p[0] == '\r' && p[1] == '\n', 0))
+            {
+                p += 2;
+                st.stage = ParseState::Stage::Body;
+                break;
+            }
+
+            // Only the part of the line not searched by an earlier call
+            const char* hEnd = StringUtils::find_crlf(data + st.scanned, end);
+            if (!hEnd)
+            {
+                st.scanned = avail;
+                return 0;
+            }
+            if (hEnd + 1 >= end)
+            {
+                st.scanned = hEnd - data;
+                return 0;
+            }
+            if (__builtin_expect(hEnd[1] != '\n', 0))
+                return reject(StatusCode::bad_request, "Malformed header line.");
+
+            // Field names are tokens: no control characters, spaces or DEL before the ':'.
+            // The CR at hEnd stops the scan anyway, bounding it by the data lets it use full strides
+            const char* colon = StringUtils::find_field_colon(p, end);
+            if (__builtin_expect(!colon || colon == p, 0))
+                return reject(StatusCode::bad_request, "Invalid header field name.");
+
+            size_t klen = colon - p;
+
+            const char* v = colon + 1;
+            if (v < hEnd && *v == ' ') ++v;
+            size_t vlen = hEnd - v;
+
+            HeaderType key = classifyHeader(p, klen);
+
+            switch (key)
+            {
+                case HeaderType::Connection:
+                    if (StringUtils::iequals_small(std::string_view(v, vlen), CLOSE_CONN_HEADER))
+                        _keepAlive = false;
+                    else if (StringUtils::iequals_small(std::string_view(v, vlen), KEEP_ALIVE_HEADER))
+                        _keepAlive = true;
+                    break;
+                case HeaderType::ContentLength:
+                    st.contentLength = StringUtils::fast_atoi(v, vlen);
+                    break;
+                case HeaderType::TransferEncoding:
+                    // Only a lone chunked coding can be decoded here
+                    if (!StringUtils::iequals_small(std::string_view(v, vlen), CHUNKED_HEADER))
+                        return reject(StatusCode::not_implemented, "Unsupported transfer coding.");
+                    st.chunked = true;
+                    break;
+                case HeaderType::Expect:
+                    if (!StringUtils::iequals_small(std::string_view(v, vlen), CONTINUE_EXPECT_HEADER))
+                        return reject(StatusCode::expectation_failed, "Unsupported expectation.");
+                    st.expectContinue = true;
+                    break;
+                default:
+                    break;
+            }
+
+            if (key != HeaderType::None)
+            {
+                _req.presentHeaders() |= headerBit(key);
+                _req.addHeader(key, v, vlen);
+            }
+            else if (!_req.addUnknownHeader(std::string_view(p, klen), std::string_view(v, vlen)))
+            {
+                return reject(StatusCode::request_header_fields_too_large, "Too many header fields.");
+            }
+
             p = hEnd + 2;
-            continue;
+            st.offset = p - data;
+            st.scanned = st.offset;
         }
 
-        size_t klen = colon - p;
+        // The blank line has not arrived yet, the segment ended right after a header
+        if (__builtin_expect(st.stage != ParseState::Stage::Body, 0))
+            return 0;
 
-        const char* v = colon + 1;
-        if (v < hEnd && *v == ' ') ++v;
-        size_t vlen = hEnd - v;
+        st.offset = p - data;
 
-        HeaderType key = HeaderType::None;
+        // Framing the two could disagree on is how requests get smuggled past proxies
+        if (__builtin_expect(st.chunked && hasHeader(_req.presentHeaders(), headerBit(HeaderType::ContentLength)), 0))
+            return reject(StatusCode::bad_request, "Both Content-Length and Transfer-Encoding present.");
 
-        switch (klen)
+        if (st.contentLength > 0 || st.chunked)
         {
-            case 10: // Connection
-                if (StringUtils::iequals_small(std::string_view(v, vlen), CLOSE_CONN_HEADER))
-                    _keepAlive = false;
-                else if (StringUtils::iequals_small(std::string_view(v, vlen), KEEP_ALIVE_HEADER))
-                    _keepAlive = true;
-                key = HeaderType::Connection;
-                break;
-            case 14: // Content-Length
-                contentLength = StringUtils::fast_atoi(v, vlen);
-                hasContentLen = true;
-                if (contentLength > Settings::getSettings().max_body_size)
-                    return false;
-                key = HeaderType::ContentLength;
-                break;
-            case 7:  // Upgrade
-                key = HeaderType::Upgrade;
-                break;
-            case 17: // Sec-WebSocket-Key
-                key = HeaderType::SecWebSocketKey;
-                break;
-            case 21: // Sec-WebSocket-Version
-                key = HeaderType::SecWebSocketVersion;
-                break;
+            Endpoint* endpoint = EndpointManager::getInstance()->getEndpoint(_req.method(), _req.path());
+
+            // A waiting client has not sent the body yet, refuse it before it costs anything
+            if (st.expectContinue && !endpoint)
+                return reject(StatusCode::not_found, "Endpoint not found.");
+
+            BodyMode mode = endpoint ? endpoint->getBodyMode() : BodyMode::Buffered;
+            const SettingsData& settings = Settings::getSettings();
+
+            usize limit = (mode == BodyMode::Buffered) ? settings.max_body_size : settings.max_upload_size;
+            if (endpoint && endpoint->getMaxBodySize() > 0)
+                limit = endpoint->getMaxBodySize();
+
+            if (__builtin_expect(st.contentLength > limit, 0))
+                return reject(StatusCode::payload_too_large, "Request body too large.");
+
+            // A buffered request has to fit the read buffer as a whole, it could never complete
+            if (__builtin_expect(mode == BodyMode::Buffered && st.offset + st.contentLength > settings.max_request_size, 0))
+                return reject(StatusCode::payload_too_large, "Request body too large.");
+
+            // Chunk sizes are checked against the same limit as they arrive
+            st.chunkDecoder.reset(limit);
+
+            // HTTP/1.0 has no interim responses, such a client just sends the body
+            if (st.expectContinue && _req.version() != "HTTP/1.0")
+            {
+                constexpr std::string_view interim = HTTP_VERSION " 100 Continue\r\n\r\n";
+                HttpResponse::writeAll(_writeBuffer, interim.data(), interim.size());
+            }
+
+            // The body may not fit the read buffer: hand the head back and stream the rest
+            if (mode != BodyMode::Buffered)
+            {
+                usize headLen = st.offset;
+                if (!beginBody(endpoint, data, headLen, st.contentLength, st.chunked, limit))
+                    return reject(StatusCode::internal_server_error, "Failed to receive request body.");
+
+                st = ParseState{};
+                return headLen;
+            }
         }
+    }
+
+    // BODY
+    if (st.chunked)
+    {
+        // Read buffers are ours to modify, so the payload is moved down over the framing
+        // and the handler still gets one contiguous body
+        char* body = const_cast<char*>(data) + st.offset;
+        const char* raw = body + st.rawBody;
+
+        ChunkedDecoder::Status status;
+        do
+        {
+            usize used;
+            std::string_view piece;
+            status = st.chunkDecoder.decode(raw, end - raw, used, piece);
+            if (!piece.empty())
+                std::memmove(body + st.chunkDecoder.decodedSize() - piece.size(), piece.data(), piece.size());
+            raw += used;
+        } while (status == ChunkedDecoder::Status::Continue);
+
+        st.rawBody = raw - body;
 
-        if (key != HeaderType::None)
+        switch (status)
         {
-            _req.presentHeaders() |= key;
+            case ChunkedDecoder::Status::NeedMore:
+                return 0;
+            case ChunkedDecoder::Status::Invalid:
+                return reject(StatusCode::bad_request, "Malformed chunked body.");
+            case ChunkedDecoder::Status::TooLarge:
+                return reject(StatusCode::payload_too_large, "Request body too large.");
+            default:
+                break;
         }
 
-        _req.addHeader(key, v, vlen);
-        p = hEnd + 2;
+        if (st.chunkDecoder.decodedSize() > 0)
+            _req.setBody(std::string_view(body, st.chunkDecoder.decodedSize()));
+
+        usize consumed = st.offset + st.rawBody;
+        st = ParseState{};
+        return consumed;
     }
 
-    // BODY
-    if (hasContentLen && contentLength > 0)
+    usize total = st.offset + st.contentLength;
+    if (avail < total)
+        return 0;
+
+    if (st.contentLength > 0)
+        _req.setBody(std::string_view(data + st.offset, st.contentLength));
+
+    // Complete, the next call starts a new request even if it lands on the same address
+    st = ParseState{};
+    return total;
+}
+
+bool Session::beginBody(Endpoint* endpoint, const char* head, usize headLen, usize contentLength, bool chunked, usize limit)
+{
+    if (endpoint->getBodyMode() == BodyMode::Spill && !_body.spill.open(Settings::getSettings().upload_spill_dir))
+        return false;
+
+    // Kept across requests, bounded by max_request_size like the head itself
+    if (_body.headCap < headLen)
+    {
+        _body.head = std::make_unique<char[]>(headLen);
+        _body.headCap = headLen;
+    }
+
+    std::memcpy(_body.head.get(), head, headLen);
+    _req.relocate(head, _body.head.get(), headLen);
+
+    _body.endpoint = endpoint;
+    _body.remaining = contentLength;
+    _body.chunked = chunked;
+    if (chunked)
+        _body.decoder.reset(limit);
+    return true;
+}
+
+usize Session::feedBody(const char* data, usize avail)
+{
+    if (!_body.chunked)
     {
-        size_t headerSize = p - data;
-        if (avail < headerSize + contentLength)
+        usize n = std::min(avail, _body.remaining);
+        if (!deliverBody(std::string_view(data, n)))
+            return 0;
+
+        _body.remaining -= n;
+        if (_body.remaining == 0)
+            finishBody();
+
+        return n;
+    }
+
+    // Chunk payloads are passed on as views of the span, nothing is copied
+    const char* p = data;
+    const char* end = data + avail;
+
+    while (true)
+    {
+        usize used;
+        std::string_view piece;
+        ChunkedDecoder::Status status = _body.decoder.decode(p, end - p, used, piece);
+
+        if (!piece.empty() && !deliverBody(piece))
+            return 0;
+        p += used;
+
+        switch (status)
+        {
+            case ChunkedDecoder::Status::Continue:
+                continue;
+            case ChunkedDecoder::Status::NeedMore:
+                return p - data;
+            case ChunkedDecoder::Status::Done:
+                finishBody();
+                return p - data;
+            case ChunkedDecoder::Status::Invalid:
+                abortBody(StatusCode::bad_request, "Malformed chunked body.");
+                return 0;
+            case ChunkedDecoder::Status::TooLarge:
+                abortBody(StatusCode::payload_too_large, "Request body too large.");
+                return 0;
+        }
+    }
+}
+
+bool Session::deliverBody(std::string_view piece)
+{
+    if (_body.endpoint->getBodyMode() == BodyMode::Spill)
+    {
+        if (!_body.spill.append(piece.data(), piece.size()))
+        {
+            abortBody(StatusCode::internal_server_error, "Failed to store request body.");
             return false;
+        }
+        return true;
+    }
 
-        _req.setBody(std::string_view(p, contentLength));
-        _readBuffer.advanceReadPos(headerSize + contentLength);
+    // Runs inline: until it returns nothing else is read, so a slow consumer holds back
+    // the socket (and the client's TCP window) instead of piling up body in memory
+    bool accepted = false;
+    try
+    {
+        accepted = _body.endpoint->execBodyChunk(_req, piece);
     }
-    else
+    catch (const std::exception& e)
+    {
+        abortBody(StatusCode::internal_server_error, "Internal Server error: " + std::string(e.what()));
+        return false;
+    }
+
+    if (!accepted)
     {
-        _readBuffer.advanceReadPos(p - data);
+        abortBody(StatusCode::bad_request, "Request body rejected.");
+        return false;
     }
 
     return true;
 }
 
+void Session::finishBody()
+{
+    if (_body.endpoint->getBodyMode() == BodyMode::Spill)
+    {
+        // A chunked upload may legitimately be empty
+        std::string_view body = _body.spill.map();
+        if (body.empty() && _body.spill.size() > 0)
+        {
+            abortBody(StatusCode::internal_server_error, "Failed to map request body.");
+            return;
+        }
+        _req.setBody(body);
+    }
+
+    _body.endpoint = nullptr;
+    handleRequest();
+
+    // The mapping backed _req.body(), the response is serialized by now
+    _body.spill.close();
+}
+
+void Session::abortBody(StatusCode status, std::string_view message)
+{
+    _body.endpoint = nullptr;
+    _body.spill.close();
+
+    // The rest of the body is still on the wire, never parse it as a request
+    _parse.stage = ParseState::Stage::Invalid;
+    rejectRequest(status, message);
+    // Body chunk callbacks may have used the arena
+    releaseRequestMemory();
+}
+
+void Session::rejectRequest(StatusCode status, std::string_view message)
+{
+    HttpResponse response;
+    response.setStatus(status);
+    response.setVersion(HTTP_VERSION);
+    response.addHeader(HeaderType::Server, APP_INFO_HEADER);
+    response.addHeader(HeaderType::Connection, CLOSE_CONN_HEADER);
+    response.initBody(&_writeBuffer, &_worker->responseHeads);
+    response.setBody(message);
+    _keepAlive = false;
+    setStatus(SessionStatus::Closing);
+}
+
+void Session::execCached(Endpoint& endpoint, HttpResponse& response)
+{
+    ResponseCache& cache = _worker->responseCache;
+    std::string_view key = ResponseCache::makeKey(_req.path(), _req.query(), _arena);
+    u64 now = ink::utils::nowMillis();
+
+    if (cache.serve(endpoint, key, now, _worker->responseHeads.date(), _writeBuffer))
+        return;
+
+    usize start = _writeBuffer.size();
+    usize queuedBodies = _bodies.size();
+    endpoint.exec(_req, response);
+
+    // Only plain, complete responses: nothing borrowed, shared or still streaming
+    if (response.getStatus() != StatusCode::ok || _stream.isOpen() ||
+        _bodies.size() != queuedBodies || _writeBuffer.truncated())
+        return;
+
+    cache.store(endpoint, key, now, _writeBuffer, start);
+}
+
 bool Session::upgradeToWebSocket()
 {
     WebSocketRoute* wsRoute = EndpointManager::getInstance()->getWebSocketEndpoint(_req.path());
@@ -472,12 +1196,10 @@ bool Session::upgradeToWebSocket()
         response.setVersion(HTTP_VERSION);
         response.addHeader(HeaderType::Server, APP_INFO_HEADER);
         response.addHeader(HeaderType::Connection, CLOSE_CONN_HEADER);
-        response.initBody(&_writeBuffer);
+        response.initBody(&_writeBuffer, &_worker->responseHeads);
         response.setBody("Invalid WebSocket upgrade request.");
         _keepAlive = false;
-#ifdef USE_IOURING
         setStatus(SessionStatus::Closing);
-#endif
     };
 
     std::string_view upgradeHeader = _req.getHeader(HeaderType::Upgrade);
@@ -530,18 +1252,22 @@ bool Session::upgradeToWebSocket()
 
 void Session::handleRequest()
 {
-    HeaderType& headers = _req.presentHeaders();
+    _worker->stats.requests++;
 
-    if (hasHeader(headers, HeaderType::Upgrade | HeaderType::SecWebSocketKey | HeaderType::SecWebSocketVersion))
+    HeaderMask headers = _req.presentHeaders();
+
+    if (hasHeader(headers, headerBit(HeaderType::Upgrade) | headerBit(HeaderType::SecWebSocketKey) | headerBit(HeaderType::SecWebSocketVersion)))
     {
         upgradeToWebSocket();
+        releaseRequestMemory();
         return;
     }
 
     HttpResponse response;
     response.setVersion(HTTP_VERSION);
     response.addHeader(HeaderType::Server, APP_INFO_HEADER);
-    response.initBody(&_writeBuffer);
+    response.initBody(&_writeBuffer, &_worker->responseHeads, &_bodies, &_stream);
+    _stream.setChunked(_req.version() != "HTTP/1.0");
 
     if (_keepAlive)
     {
@@ -550,9 +1276,7 @@ void Session::handleRequest()
     else
     {
         response.addHeader(HeaderType::Connection, CLOSE_CONN_HEADER);
-#ifdef USE_IOURING
         setStatus(SessionStatus::Closing);
-#endif
     }
 
     try
@@ -561,7 +1285,11 @@ void Session::handleRequest()
 
         if (endpoint != nullptr)
         {
-            endpoint->exec(_req, response);
+            // Cached bytes carry Connection: keep-alive, closing requests always run the handler
+            if (endpoint->getCacheTtl() > 0 && _keepAlive)
+                execCached(*endpoint, response);
+            else
+                endpoint->exec(_req, response);
         }
         else
         {
@@ -571,15 +1299,99 @@ void Session::handleRequest()
     }
     catch (const std::exception& e)
     {
-        response.setStatus(StatusCode::internal_server_error);
-        if (_keepAlive)
+        if (_stream.isOpen())
         {
-            response.addHeader(HeaderType::Connection, CLOSE_CONN_HEADER);
-#ifdef USE_IOURING
-            setStatus(SessionStatus::Closing);
-#endif
+            // The head is out already, closing is the only error left to report
+            INK_ERROR << "Response stream failed: " << e.what();
+            _stream.abort();
             _keepAlive = false;
+            setStatus(SessionStatus::Closing);
+        }
+        else
+        {
+            response.setStatus(StatusCode::internal_server_error);
+            if (_keepAlive)
+            {
+                response.addHeader(HeaderType::Connection, CLOSE_CONN_HEADER);
+                setStatus(SessionStatus::Closing);
+                _keepAlive = false;
+            }
+            response.setBody("Internal Server error: " + std::string(e.what()));
         }
-        response.setBody("Internal Server error: " + std::string(e.what()));
     }
+
+    // An unframed HTTP/1.0 body only ends with the connection
+    if (_stream.isOpen() && !_stream.isChunked())
+    {
+        _keepAlive = false;
+        setStatus(SessionStatus::Closing);
+    }
+
+    // Written in full by the handler, otherwise the continuation takes over
+    if (_stream.isOpen() && !_stream.isWaiting())
+        _stream.end();
+
+    // io_uring ignores completions of closing sessions, which is where the continuation runs;
+    // without keep-alive completeWrite() closes once the whole body went out
+    if (_stream.isWaiting())
+        setStatus(SessionStatus::Active);
+
+    // A borrowed body points into the request, which goes away once this returns
+    if (_bodies.hasBorrowed())
+    {
+        if (_worker->backend == IoBackend::Epoll)
+        {
+            onWriteReady();
+            _bodies.adoptBorrowed();
+        }
+        else
+        {
+            keepBorrowedBodies();
+        }
+    }
+
+    // A waiting continuation may still use the arena, pumpStream() releases it then
+    if (!_stream.isOpen())
+        releaseRequestMemory();
+}
+
+void Session::keepBorrowedBodies()
+{
+    if (_inPlace.data)
+    {
+        const char* end = _inPlace.data + _inPlace.len;
+        if (!_inPlace.pin && _bodies.borrowedIn(_inPlace.data, end))
+        {
+            ProvidedBufferRing* bufRing = _worker->bufRing;
+            u16 bid = _inPlace.bid;
+            _inPlace.pin = std::shared_ptr<const void>(_inPlace.data, [bufRing, bid](const void*) {
+                bufRing->recycle(bid);
+            });
+        }
+
+        if (_inPlace.pin)
+            _bodies.pinBorrowed(_inPlace.data, end, _inPlace.pin);
+    }
+
+    // What followed a partial request is parsed out of the read buffer. A multishot recv
+    // copies into it whenever it completes, it cannot wait for pinned bytes
+    if (_readBuffer && !(_worker->bufRing && Settings::getSettings().multishot_recv))
+    {
+        MirrorBuffer* readBuffer = _readBuffer.get();
+        if (const char* oldest = _bodies.borrowedIn(readBuffer->begin(), readBuffer->end()))
+        {
+            readBuffer->pin(oldest);
+            std::shared_ptr<const void> pin(oldest, [readBuffer](const void*) { readBuffer->unpin(); });
+            _bodies.pinBorrowed(readBuffer->begin(), readBuffer->end(), pin);
+        }
+    }
+
+    _bodies.adoptBorrowed();
+}
+
+void Session::releaseRequestMemory()
+{
+    // Decoded query views point into the arena
+    _req.dropQueryCache();
+    _arena.reset();
 }
@@ -3,11 +3,18 @@
 
 #pragma once
 
-#include <ink/RingBuffer.h>
 #include <ink/TimerWheel.h>
 #include "WarpDefs.h"
 #include "Request/HttpRequest.h"
+#include "Response/BodyQueue.h"
+#include "Response/ResponseWriter.h"
 #include "Server/WebSocket.h"
+#include "Utils/ChunkedDecoder.h"
+#include "Utils/MirrorBuffer.h"
+#include "Utils/SpillFile.h"
+
+struct WorkerContext;
+class Endpoint;
 
 /**
  * @class Session
@@ -25,6 +32,9 @@
  */
 class WARP_API Session : public ink::TimerNode {
 public:
+    /** @brief Constructs a session with a socket descriptor owned by @p worker. */
+    explicit Session(socket_t socket, WorkerContext* worker);
+
     /** @brief Closes the underlying socket and cleans up session state on destruction. */
     ~Session();
 
@@ -37,16 +47,60 @@ public:
     /** @brief Returns the raw file descriptor for this session. */
     socket_t getSocket() const noexcept;
 
+    /**
+     * @brief CPU that processed this connection's packets (SO_INCOMING_CPU).
+     * @return -1 when unknown, e.g. for fixed-file (direct) descriptors.
+     */
+    i32 incomingCpu() const noexcept;
+
 public:
     u64 lastActivityTick = 0;
+    // In the worker's ready list, waiting for another read turn (epoll)
+    bool readyQueued = false;
 
 private:
+    /** @brief Runs processHttp() over the read buffer until it stops making progress. */
+    void processHttpBuffer();
+
+    /**
+     * @brief Parses requests out of a span, streams the bodies of Stream and Spill
+     *        endpoints and runs the handlers.
+     * @return Bytes consumed, the rest must be offered again with more data behind it.
+     */
+    usize processHttp(const char* data, usize avail);
+
     /**
-     * @brief Parse the request stream, extracting headers and body
+     * @brief Parses one request out of an arbitrary contiguous span.
      *
-     * Use integer cmp in headers parse, and, avoid allocations for the body received using string views
+     * Resumable: when the span ends mid-request the position reached is kept in _parse,
+     * and the next call with the same span start continues from there instead of byte 0.
+     * When the endpoint streams or spills its body, returns once the head is parsed and
+     * leaves the body to feedBody().
+     * @return Bytes consumed by the request, 0 if the span holds no complete request.
      */
-    bool parseRequest();
+    usize parseRequest(const char* data, usize avail);
+
+    /**
+     * @brief Copies the request head out of the read buffer and switches to feeding the
+     *        body of @p endpoint, @p contentLength bytes or chunked up to @p limit.
+     * @return false if the spill file could not be created.
+     */
+    bool beginBody(Endpoint* endpoint, const char* head, usize headLen, usize contentLength, bool chunked, usize limit);
+
+    /** @brief Passes raw body bytes on, de-chunking them first if needed. @return Bytes consumed. */
+    usize feedBody(const char* data, usize avail);
+
+    /** @brief Hands decoded body bytes to the endpoint's chunk handler or spill file. @return false once aborted. */
+    bool deliverBody(std::string_view piece);
+
+    /** @brief Runs the handler once the whole streamed body went through. */
+    void finishBody();
+
+    /** @brief Drops the streamed body and rejects the request. */
+    void abortBody(StatusCode status, std::string_view message);
+
+    /** @brief Rewinds the request arena once nothing of the request can touch it anymore. */
+    void releaseRequestMemory();
 
     /**
      * @brief This executes the logic for each endpoint (route) called throught a request
@@ -63,6 +117,12 @@ private:
      */
     bool upgradeToWebSocket();
 
+    /** @brief Answers from the worker's ResponseCache, or runs the handler and keeps its response there. */
+    void execCached(Endpoint& endpoint, HttpResponse& response);
+
+    /** @brief Queues an error response with Connection: close and starts closing the session. */
+    void rejectRequest(StatusCode status, std::string_view message);
+
     /** @brief Encodes and queues a WebSocket frame. Called exclusively by WebSocketContext. */
     void wsFrameSend(u8 opcode, std::string_view payload, bool fin = true);
 
@@ -74,43 +134,66 @@ private:
     };
 
     socket_t _socket;
+    // Scratch memory of the current request, rewound once it and its streamed response are done
+    BumpArena _arena;
     HttpRequest _req;
     bool _keepAlive;
     ProtocolMode _mode = ProtocolMode::Http;
     ws::WsState _wsState;
 
-    ink::RingBuffer _readBuffer;
-    ink::RingBuffer _writeBuffer;
+    // Null while a provided-buffer session holds no partial request
+    std::unique_ptr<MirrorBuffer> _readBuffer;
+    MirrorBuffer _writeBuffer;
+    // Large response bodies sent in place, spliced between the write buffer bytes
+    BodyQueue _bodies;
+    // Chunked response still being produced, no further request is handled until it ends
+    ResponseWriter _stream;
 
-#ifdef USE_EPOLL
-public:
-    /** @brief Constructs a session with a raw socket descriptor. */
-    explicit Session(socket_t socket, socket_t assignedEpollFd);
+    WorkerContext* _worker;
 
+    // epoll backend: readiness driven, the session performs the syscalls itself
+public:
     socket_t getAssignedEpollFd() const noexcept;
 
-    // Called by the Worker Thread Loop
+    /**
+     * @brief Called by the Worker Thread Loop. Reads and handles input until EAGAIN or until
+     *        this turn's session_request_budget / session_read_budget is used up.
+     */
     bool onReadReady();
     bool onWriteReady();
 
+    /**
+     * @brief The last onReadReady() stopped on its budget, or a streamed response ended
+     *        while reads were held back: input may still be waiting.
+     */
+    bool hasPendingInput() const noexcept { return _inputPending; }
+
 private:
     void onWriteComplete();
-    socket_t _assignedEpollFd;
-#endif
 
-#ifdef USE_IOURING
+    // io_uring backend: completion driven, the session only prepares SQEs
 public:
-    /** @brief Constructs a session with a raw socket descriptor. */
-    explicit Session(socket_t socket);
-
     /**
      * @brief Prepares an SQE for a non-blocking receive operation.
+     *
+     * With a provided buffer ring and no partial request pending, the recv is armed with
+     * IOSQE_BUFFER_SELECT so the kernel only picks a buffer once data arrives. When
+     * multishot_recv is enabled that recv stays armed until the kernel terminates it.
      * @param sqe Pointer to a submission queue entry obtained from the ring.
      */
     void onReadReady(io_uring_sqe* sqe);
 
     /**
-     * @brief Prepares an SQE for a zero-copy send operation.
+     * @brief Prepares an SQE cancelling the in-flight recv (single or multishot).
+     * @param sqe Pointer to a submission queue entry obtained from the ring.
+     */
+    void cancelRead(io_uring_sqe* sqe);
+
+    /**
+     * @brief Prepares an SQE for a send operation.
+     *
+     * Writes below zerocopy_send_threshold use a plain copying send, larger ones send_zc.
+     * With bodies queued or overflow segments in use everything goes out together through sendmsg.
      * @param sqe Pointer to a submission queue entry obtained from the ring.
      */
     void onWriteReady(io_uring_sqe* sqe);
@@ -123,9 +206,10 @@ public:
 
     /**
      * @brief Processes data received from the kernel.
+     * @param cqeFlags CQE flags, carrying the provided buffer id when IORING_CQE_F_BUFFER is set.
      * @return true if session remains active, false if it should be closed.
      */
-    bool processRead(i32 bytesRecv, io_uring* ring);
+    bool processRead(i32 bytesRecv, u32 cqeFlags, io_uring* ring);
 
     bool isReadInFlight()    const { return (_ioFlags & IO_READING)    != 0; }
     bool isWriteInFlight()   const { return (_ioFlags & IO_WRITING)    != 0; }
@@ -146,9 +230,131 @@ public:
     void resetIoState() { _ioFlags = IO_NONE; }
 
 private:
+    /**
+     * @brief Consumes a kernel-selected buffer. Complete requests are parsed in place;
+     * only a trailing partial request is copied into the session's own read buffer.
+     * @return false if the leftover does not fit in max_request_size.
+     */
+    bool consumeProvidedBuffer(const char* data, usize len);
+
+    /**
+     * @brief Borrowed bodies of the request just handled go out of the read memory they point
+     *        into, which is held until they were sent: the provided buffer parsed in place, or
+     *        the private read buffer. Bodies anywhere else are copied.
+     */
+    void keepBorrowedBodies();
+
+    /** @brief Prepares a sendmsg (or sendmsg_zc) of the write buffer, its segments and the queued bodies. */
+    void sendGathered(io_uring_sqe* sqe);
+
+    /** @brief The write buffer dropped bytes past its overflow limit, logged once per session. */
+    bool isWriteTruncated();
+
+    /** @brief IOSQE_FIXED_FILE when _socket is a fixed-file slot rather than a process fd. */
+    u8 fixedFileFlag() const noexcept;
+
+    /** @brief Runs the protocol handlers over whatever sits in _readBuffer. */
+    void processReadBuffer();
+
+    /** @brief processReadBuffer() over bytes received into the private buffer, ends the ENOBUFS fallback once they drained. */
+    void drainReadBuffer();
+
+    /** @brief Drops the private read buffer of a provided-buffer session once it is empty and not falling back. */
+    void releaseReadBuffer();
+
+    /**
+     * @brief Releases @p bytesSent from the write buffer and continues with the next write.
+     * @return false if the session should be closed.
+     */
+    bool completeWrite(usize bytesSent, io_uring* ring);
+
+    /** @brief Runs the stream's continuation while the queued output is below half of max_response_size. */
+    void pumpStream();
+
+    /** @brief Response bytes not sent yet, write buffer and queued bodies. */
+    usize pendingOutput() const noexcept { return _writeBuffer.size() + _bodies.size(); }
+
+    /**
+     * @brief True while enough response bytes are queued that reading more requests would only grow
+     *        them, or while a streamed response holds the connection.
+     */
+    bool isWriteBackpressured() const;
+
+    /** @brief Processes reads staged while paused and re-arms the recv once the write side drained. */
+    void resumeRead(io_uring* ring);
+
     SessionStatus _status = SessionStatus::Active;
     IoStateFlags _ioFlags = IO_NONE;
 
+    // Reads are staged but not parsed while the write side is backpressured
+    bool _readPaused = false;
+
+    // The buffer ring ran dry (ENOBUFS): recv into _readBuffer until a request drained from it
+    bool _fallbackRead = false;
+
+    // Provided buffer consumeProvidedBuffer() is parsing in place. Once a borrowed body
+    // points into it, pin owns it and recycles it after the body was sent
+    struct InPlaceRead {
+        const char* data = nullptr;
+        usize len = 0;
+        u16 bid = 0;
+        std::shared_ptr<const void> pin;
+    };
+
+    InPlaceRead _inPlace;
+
+    // Requests the current epoll read turn may still run, io_uring sessions are not budgeted
+    static constexpr u32 NO_REQUEST_BUDGET = ~0u;
+    u32 _requestBudget = NO_REQUEST_BUDGET;
+    bool _inputPending = false;
+
+    /**
+     * @brief How far parseRequest() got into a partially received request.
+     * Offsets are relative to the request start, @ref base. If the next span starts
+     * elsewhere the partial request was staged byte for byte into a new buffer: the
+     * views in _req are moved along and parsing continues where it stopped.
+     */
+    struct ParseState {
+        enum class Stage : u8 {
+            RequestLine = 0,
+            Headers,
+            Body,
+            Invalid // Rejected with 400, nothing after it is parsed
+        };
+
+        Stage stage = Stage::RequestLine;
+        const char* base = nullptr;
+        usize offset = 0;   // Start of the next header line, or of the body
+        usize scanned = 0;  // No CR between offset and here, the CRLF search resumes here
+        usize contentLength = 0;
+        bool expectContinue = false; // Client waits for a 100 Continue before sending the body
+
+        // Transfer-Encoding: chunked, de-chunked in place: payload is compacted to the
+        // body start over the framing, rawBody bytes past the body start were decoded
+        bool chunked = false;
+        usize rawBody = 0;
+        ChunkedDecoder chunkDecoder;
+    };
+
+    ParseState _parse;
+
+    /**
+     * @brief Body of a Stream or Spill request, received after its head was parsed.
+     * The head is copied here first so _req stays valid while body bytes flow through
+     * and out of the read buffer; at most one read buffer of body is held at a time.
+     */
+    struct BodyState {
+        Endpoint* endpoint = nullptr; // Set while a body is being received
+        usize remaining = 0;          // Content-Length bytes still expected
+        bool chunked = false;
+        ChunkedDecoder decoder;
+        std::unique_ptr<char[]> head;
+        usize headCap = 0;
+        SpillFile spill;
+    };
+
+    BodyState _body;
+
     /**
      * @brief Operation scope for a session to avoid using dynamic allocs.
      * Works like a wrapper to grab the context of the session.
@@ -157,7 +363,6 @@ private:
     IoRequest _writeReq{this, OperationType::Write};
 
     usize _lockedZcBytes = 0;
-#endif
 };
 
 #endif // SESSION_H
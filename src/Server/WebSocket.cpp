@@ -12,7 +12,7 @@ std::array<u8, SHA_DIGEST_LENGTH> sha1Digest(std::string_view input)
     return out;
 }
 
-void sendFrame(ink::RingBuffer& writeBuf, u8 opcode, std::string_view payload, bool fin)
+void sendFrame(MirrorBuffer& writeBuf, u8 opcode, std::string_view payload, bool fin)
 {
     u8 hdr[14];
     usize hdrLen = 0;
@@ -46,7 +46,7 @@ void sendFrame(ink::RingBuffer& writeBuf, u8 opcode, std::string_view payload, b
 static bool dispatchFrame(WsState& state, WebSocketContext& ctx,
                           u8 opcode, bool fin,
                           const char* payload, usize payloadLen,
-                          ink::RingBuffer& writeBuf)
+                          MirrorBuffer& writeBuf)
 {
     if (!fin)
     {
@@ -95,7 +95,7 @@ static bool dispatchFrame(WsState& state, WebSocketContext& ctx,
 }
 
 bool processFrames(WsState& state, WebSocketContext& ctx,
-                   ink::RingBuffer& readBuf, ink::RingBuffer& writeBuf)
+                   MirrorBuffer& readBuf, MirrorBuffer& writeBuf)
 {
     while (true)
     {
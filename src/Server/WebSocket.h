@@ -3,6 +3,7 @@
 
 #include <openssl/sha.h>
 #include "WarpDefs.h"
+#include "Utils/MirrorBuffer.h"
 
 namespace ws {
 
@@ -46,7 +47,7 @@ struct WsState {
  * @param payload  Frame payload.
  * @param fin      Whether this is the final fragment (true for all non-fragmented frames).
  */
-void sendFrame(ink::RingBuffer& writeBuf, u8 opcode, std::string_view payload, bool fin = true);
+void sendFrame(MirrorBuffer& writeBuf, u8 opcode, std::string_view payload, bool fin = true);
 
 /**
  * @brief Drains and processes all complete WebSocket frames from the read buffer.
@@ -61,7 +62,7 @@ void sendFrame(ink::RingBuffer& writeBuf, u8 opcode, std::string_view payload, b
  * @return true to keep the connection alive, false to close it.
  */
 bool processFrames(WsState& state, WebSocketContext& ctx,
-                   ink::RingBuffer& readBuf, ink::RingBuffer& writeBuf);
+                   MirrorBuffer& readBuf, MirrorBuffer& writeBuf);
 
 }
 
@@ -7,6 +7,7 @@
 
 #include "Endpoint/Endpoint.h"
 #include "Managers/EndpointManager.h"
+#include "Response/ResponseCache.h"
 
 class WARP_API BaseService
 {
@@ -16,12 +17,65 @@ public:
 
     virtual void registerAllEndpoints() = 0;
 
+    /** @param maxBodySize Per-route body limit, 0 uses the configured one. */
     virtual void registerEndpoint(const std::string& route,
                                   const Method method,
-                                  RequestHandler reqHandler)
+                                  RequestHandler reqHandler,
+                                  usize maxBodySize = 0)
     {
         Endpoint* endpoint = new Endpoint(route, method);
         endpoint->setHandlerCallback(reqHandler);
+        endpoint->setMaxBodySize(maxBodySize);
+        EndpointManager::getInstance()->registerEndpoint(endpoint);
+    }
+
+    /**
+     * @brief Endpoint whose 200 responses are kept for @p ttlMs and replayed without calling
+     *        @p reqHandler, for responses that depend on nothing but the path and the query.
+     * @param budget Bytes of cached responses per worker.
+     */
+    virtual void registerCachedEndpoint(const std::string& route,
+                                        const Method method,
+                                        RequestHandler reqHandler,
+                                        u32 ttlMs,
+                                        usize budget = RESPONSE_CACHE_DEFAULT_BUDGET)
+    {
+        Endpoint* endpoint = new Endpoint(route, method);
+        endpoint->setHandlerCallback(reqHandler);
+        endpoint->setResponseCache(ttlMs, budget);
+        EndpointManager::getInstance()->registerEndpoint(endpoint);
+    }
+
+    /**
+     * @brief Endpoint whose body is not buffered: @p onChunk receives it piece by piece
+     *        as it arrives, then @p reqHandler answers with an empty body().
+     */
+    virtual void registerStreamingEndpoint(const std::string& route,
+                                           const Method method,
+                                           BodyChunkHandler onChunk,
+                                           RequestHandler reqHandler,
+                                           usize maxBodySize = 0)
+    {
+        Endpoint* endpoint = new Endpoint(route, method);
+        endpoint->setHandlerCallback(reqHandler);
+        endpoint->setBodyChunkCallback(onChunk);
+        endpoint->setMaxBodySize(maxBodySize);
+        EndpointManager::getInstance()->registerEndpoint(endpoint);
+    }
+
+    /**
+     * @brief Endpoint that needs the whole body but may receive more than max_body_size:
+     *        the body is spilled to a temp file and body() is a read-only mapping of it.
+     */
+    virtual void registerSpillingEndpoint(const std::string& route,
+                                          const Method method,
+                                          RequestHandler reqHandler,
+                                          usize maxBodySize = 0)
+    {
+        Endpoint* endpoint = new Endpoint(route, method);
+        endpoint->setHandlerCallback(reqHandler);
+        endpoint->setBodyMode(BodyMode::Spill);
+        endpoint->setMaxBodySize(maxBodySize);
         EndpointManager::getInstance()->registerEndpoint(endpoint);
     }
 
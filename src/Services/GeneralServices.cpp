@@ -22,15 +22,14 @@ void GeneralServices::registerAllEndpoints()
                      [&](const HttpRequest& request, HttpResponse& response)
     {
         // response.setHeader(boost::beast::http::field::connection, "keep-alive");
-        const auto& params = request.queryParams();
         const auto& body = request.body();
         auto jObj = ink::EnhancedJsonUtils::loadFromString(body.data());
 
         auto result = ink::EnhancedJson();
 
-        for (auto it=params.begin(); it != params.end(); ++it)
+        for (usize i = 0; i < request.queryParamCount(); ++i)
         {
-            result[it->first] = it->second;
+            result[std::string(request.queryKey(i))] = std::string(request.queryValue(i));
         }
 
         for (auto it=jObj.begin(); it != jObj.end(); ++it)
@@ -55,8 +54,8 @@ void GeneralServices::registerAllEndpoints()
     registerEndpoint("/apibenchmark", Method::POST,
     [&](const HttpRequest& request, HttpResponse& response)
     {
-        const auto& body = request.body();
-        response.setBody(body);
+        // Echoed from the read buffer without a copy when the socket takes it right away
+        response.setBorrowedBody(request.body());
     });
 
     registerEndpoint("/health", Method::GET,
@@ -72,8 +71,9 @@ void GeneralServices::registerAllEndpoints()
         response.setBody(obj.toCompactString());
     });
 
-    registerEndpoint("/version", Method::GET,
-                     [&](const HttpRequest& request, HttpResponse& response)
+    // Never changes at runtime, one second keeps every worker from re-serializing it per hit
+    registerCachedEndpoint("/version", Method::GET,
+                           [&](const HttpRequest& request, HttpResponse& response)
     {
         auto obj = ink::EnhancedJson();
         obj["major"] = 1;
@@ -82,7 +82,7 @@ void GeneralServices::registerAllEndpoints()
         obj["text"] = "1.0.0";
 
         response.setBody(obj.toPrettyString());
-    });
+    }, 1000);
 
     registerWebSocketEndpoint("/ws/echo", {
         [](WebSocketContext& ctx) {
@@ -29,6 +29,60 @@ bool SettingsData::isValid() const {
         return false;
     }
 
+    // Buffer ring entries are indexed by a u16 bid and masked, so they must be a power of two
+    if (provided_buffers)
+    {
+        if (provided_buffer_count == 0 || provided_buffer_count > 32768 ||
+            (provided_buffer_count & (provided_buffer_count - 1)) != 0)
+        {
+            INK_ERROR << "provided_buffer_count must be a power of two up to 32768";
+            return false;
+        }
+
+        if (provided_buffer_size == 0)
+        {
+            INK_ERROR << "provided_buffer_size must be greater than 0";
+            return false;
+        }
+    }
+
+    if (worker_response_overflow > 0 && worker_response_overflow < max_response_overflow) {
+        INK_ERROR << "worker_response_overflow cannot be smaller than max_response_overflow";
+        return false;
+    }
+
+    if (upload_spill_dir.empty()) {
+        INK_ERROR << "upload_spill_dir cannot be empty";
+        return false;
+    }
+
+    if (session_request_budget == 0 || session_read_budget == 0) {
+        INK_ERROR << "session_request_budget and session_read_budget must be greater than 0";
+        return false;
+    }
+
+    if (busy_poll_us > 0 && busy_poll_budget == 0) {
+        INK_ERROR << "busy_poll_budget must be greater than 0";
+        return false;
+    }
+
+    if (direct_descriptors && direct_descriptor_table_size == 0) {
+        INK_ERROR << "direct_descriptor_table_size must be greater than 0";
+        return false;
+    }
+
+    // Handed-off sockets arrive as plain fds, the receiving worker has no slot for them
+    if (accept_mode == AcceptMode::Central && direct_descriptors) {
+        INK_ERROR << "direct_descriptors cannot be combined with accept_mode central";
+        return false;
+    }
+
+    // Multishot recv can only ever complete into kernel-selected buffers
+    if (multishot_recv && !provided_buffers) {
+        INK_ERROR << "multishot_recv requires provided_buffers";
+        return false;
+    }
+
     return true;
 }
 
@@ -74,6 +128,51 @@ bool Settings::loadSettings(const ink::EnhancedJson& configs, SettingsData& data
         data.max_body_size = configs.get<size_t>("max_body_size", 64 * 1024);
         data.max_request_size = configs.get<size_t>("max_request_size", 64 * 1024);
         data.max_response_size = configs.get<size_t>("max_response_size", 64 * 1024);
+        data.max_response_overflow = configs.get<size_t>("max_response_overflow", 4 * 1024 * 1024);
+        data.worker_response_overflow = configs.get<size_t>("worker_response_overflow", 256 * 1024 * 1024);
+        data.max_upload_size = configs.get<size_t>("max_upload_size", 64 * 1024 * 1024);
+        data.upload_spill_dir = configs.get<std::string>("upload_spill_dir", "/tmp");
+        data.cpu_steering = configs.get<bool>("cpu_steering", false);
+
+        std::string backend = configs.get<std::string>("backend", "auto");
+        if (backend == "auto")
+            data.backend = IoBackend::Auto;
+        else if (backend == "epoll")
+            data.backend = IoBackend::Epoll;
+        else if (backend == "io_uring")
+            data.backend = IoBackend::IoUring;
+        else
+            throw std::runtime_error("Unknown backend: " + backend);
+
+        std::string acceptMode = configs.get<std::string>("accept_mode", "reuseport");
+        if (acceptMode == "reuseport")
+            data.accept_mode = AcceptMode::ReusePort;
+        else if (acceptMode == "central")
+            data.accept_mode = AcceptMode::Central;
+        else
+            throw std::runtime_error("Unknown accept_mode: " + acceptMode);
+
+        std::string ringMode = configs.get<std::string>("ring_mode", "sqpoll");
+        if (ringMode == "sqpoll")
+            data.ring_mode = RingSetupMode::SqPollPerWorker;
+        else if (ringMode == "shared_sqpoll")
+            data.ring_mode = RingSetupMode::SharedSqPoll;
+        else if (ringMode == "defer_taskrun")
+            data.ring_mode = RingSetupMode::DeferTaskrun;
+        else
+            throw std::runtime_error("Unknown ring_mode: " + ringMode);
+
+        data.session_request_budget = configs.get<u32>("session_request_budget", 16);
+        data.session_read_budget = configs.get<size_t>("session_read_budget", 64 * 1024);
+        data.busy_poll_us = configs.get<u32>("busy_poll_us", 0);
+        data.busy_poll_budget = configs.get<u16>("busy_poll_budget", 8);
+        data.provided_buffers = configs.get<bool>("provided_buffers", false);
+        data.provided_buffer_count = configs.get<u32>("provided_buffer_count", 4096);
+        data.provided_buffer_size = configs.get<u32>("provided_buffer_size", 4096);
+        data.multishot_recv = configs.get<bool>("multishot_recv", false);
+        data.zerocopy_send_threshold = configs.get<size_t>("zerocopy_send_threshold", 8192);
+        data.direct_descriptors = configs.get<bool>("direct_descriptors", false);
+        data.direct_descriptor_table_size = configs.get<u32>("direct_descriptor_table_size", 65536);
 
         return true;
     }
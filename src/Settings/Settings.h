@@ -15,6 +15,39 @@ struct WARP_API SettingsData {
     size_t max_body_size;
     size_t max_request_size;
     size_t max_response_size;
+    // Bytes a session's write buffer may chain past max_response_size, and all sessions of a worker together.
+    // A write past either limit closes the connection; with max_response_overflow = 0 nothing is chained
+    // and any response larger than max_response_size closes it
+    size_t max_response_overflow;
+    size_t worker_response_overflow;
+    // Body limit of streaming and spilling endpoints, and where spilled bodies go
+    size_t max_upload_size;
+    std::string upload_spill_dir;
+
+    IoBackend backend;
+    AcceptMode accept_mode;
+    // Steer each connection to the listener of the worker on the CPU that received it
+    bool cpu_steering;
+    RingSetupMode ring_mode;
+    // Requests and bytes a session may take per epoll read turn before others get theirs
+    u32 session_request_budget;
+    size_t session_read_budget;
+    // Spin this long on non-blocking polls before a worker blocks, 0 disables busy polling
+    u32 busy_poll_us;
+    // Packets per NAPI busy-poll pass (SO_BUSY_POLL_BUDGET / epoll busy_poll_budget)
+    u16 busy_poll_budget;
+
+    // io_uring provided buffer ring (recv buffers picked by the kernel)
+    bool provided_buffers;
+    u32 provided_buffer_count;
+    u32 provided_buffer_size;
+    // Arm one recv per session and keep it alive across completions (needs provided_buffers)
+    bool multishot_recv;
+    // Writes at least this large use send_zc, smaller ones a plain send
+    size_t zerocopy_send_threshold;
+    // Accept straight into a per-worker sparse fixed-file table
+    bool direct_descriptors;
+    u32 direct_descriptor_table_size;
 
     // Add validation function
     bool isValid() const;
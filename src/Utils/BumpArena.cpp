@@ -0,0 +1,98 @@
+#include "BumpArena.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+BumpArena::BumpArena(usize blockSize, Totals* totals) :
+    _blockSize(blockSize),
+    _resource(*this),
+    _totals(totals ? totals : &_ownTotals)
+{
+    // Empty
+}
+
+BumpArena::~BumpArena()
+{
+    reset();
+
+    Block* b = _head;
+    while (b)
+    {
+        Block* next = b->next;
+        std::free(b);
+        b = next;
+    }
+}
+
+BumpArena::Block* BumpArena::newBlock(usize size)
+{
+    void* mem = std::malloc(offsetof(Block, data) + size);
+    if (!mem)
+        throw std::bad_alloc();
+
+    Block* b = static_cast<Block*>(mem);
+    b->next = nullptr;
+    b->size = size;
+    _totals->heapBlocks++;
+    return b;
+}
+
+void* BumpArena::allocate(usize bytes, usize align)
+{
+    _totals->allocations++;
+
+    // Too big to share a block, give it its own until the next reset
+    if (bytes + align > _blockSize)
+    {
+        Block* b = newBlock(bytes + align);
+        b->next = _large;
+        _large = b;
+
+        usize addr = reinterpret_cast<usize>(b->data);
+        return reinterpret_cast<void*>((addr + align - 1) & ~(align - 1));
+    }
+
+    if (!_current)
+        _head = _current = newBlock(_blockSize);
+
+    while (true)
+    {
+        usize base = reinterpret_cast<usize>(_current->data);
+        usize aligned = (base + _offset + align - 1) & ~(align - 1);
+        usize end = aligned + bytes;
+
+        if (end <= base + _current->size)
+        {
+            _offset = end - base;
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        // Move on to the next retained block, or grow the chain
+        if (!_current->next)
+            _current->next = newBlock(_blockSize);
+
+        _current = _current->next;
+        _offset = 0;
+    }
+}
+
+std::string_view BumpArena::copy(std::string_view str)
+{
+    char* out = static_cast<char*>(allocate(str.size(), 1));
+    std::memcpy(out, str.data(), str.size());
+    return std::string_view(out, str.size());
+}
+
+void BumpArena::reset() noexcept
+{
+    _current = _head;
+    _offset = 0;
+
+    while (_large)
+    {
+        Block* next = _large->next;
+        std::free(_large);
+        _large = next;
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef BUMPARENA_H
+#define BUMPARENA_H
+
+#pragma once
+
+#include <ink/ink_base.hpp>
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+
+/**
+ * @class BumpArena
+ * @brief Pointer-bump allocator for memory that lives exactly as long as one request.
+ *
+ * Allocations are carved from a chain of blocks and never freed one by one; reset()
+ * rewinds everything at once and keeps the regular blocks for the next request, so a
+ * warm arena never touches the heap. Allocations larger than a block get a dedicated
+ * block that is released on reset(). Destructors of objects placed in the arena are
+ * not run, use it for trivially destructible data or through resource() for pmr
+ * containers that do not outlive the request.
+ */
+class BumpArena
+{
+public:
+    // Counters several arenas can share, e.g. every session of a worker
+    struct Totals {
+        u64 allocations = 0;
+        u64 heapBlocks = 0;
+    };
+
+    /** @brief No memory is taken until the first allocation. Counts go to @p totals when given. */
+    explicit BumpArena(usize blockSize, Totals* totals = nullptr);
+    ~BumpArena();
+
+    BumpArena(const BumpArena&) = delete;
+    BumpArena& operator=(const BumpArena&) = delete;
+
+    void* allocate(usize bytes, usize align = alignof(std::max_align_t));
+
+    /** @brief Copies @p str into the arena. */
+    std::string_view copy(std::string_view str);
+
+    /** @brief Releases every allocation made since the last reset. */
+    void reset() noexcept;
+
+    /** @brief std::pmr adapter, deallocation is a no-op until reset(). */
+    std::pmr::memory_resource* resource() noexcept { return &_resource; }
+
+    // Totals since construction, of every arena sharing them
+    u64 allocations() const noexcept { return _totals->allocations; }
+    u64 heapBlocks() const noexcept { return _totals->heapBlocks; }
+
+private:
+    struct Block {
+        Block* next;
+        usize size;
+        alignas(std::max_align_t) char data[1];
+    };
+
+    class Resource : public std::pmr::memory_resource {
+    public:
+        explicit Resource(BumpArena& arena) : _arena(arena) {}
+
+    private:
+        void* do_allocate(usize bytes, usize align) override { return _arena.allocate(bytes, align); }
+        void do_deallocate(void*, usize, usize) override {}
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+        BumpArena& _arena;
+    };
+
+    Block* newBlock(usize size);
+
+    usize _blockSize;
+
+    // Regular blocks, _current is the one being bumped
+    Block* _head = nullptr;
+    Block* _current = nullptr;
+    usize _offset = 0;
+
+    // Oversized allocations, freed on reset
+    Block* _large = nullptr;
+
+    Resource _resource;
+
+    Totals _ownTotals;
+    Totals* _totals;
+};
+
+#endif // BUMPARENA_H
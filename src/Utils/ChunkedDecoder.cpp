@@ -0,0 +1,104 @@
+#include "ChunkedDecoder.h"
+
+#include "StringUtils.h"
+
+#include <algorithm>
+
+namespace {
+
+inline i32 hexValue(char c) noexcept
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+} // namespace
+
+ChunkedDecoder::Status ChunkedDecoder::decode(const char* data, usize len, usize& consumed, std::string_view& payload) noexcept
+{
+    consumed = 0;
+    payload = {};
+
+    const char* end = data + len;
+
+    switch (_stage)
+    {
+        case Stage::Size:
+        {
+            const char* lineEnd = StringUtils::find_crlf(data, end);
+            if (!lineEnd || lineEnd + 1 >= end)
+                return len > MAX_CHUNK_LINE_SIZE ? Status::Invalid : Status::NeedMore;
+            if (lineEnd[1] != '\n' || static_cast<usize>(lineEnd - data) > MAX_CHUNK_LINE_SIZE)
+                return Status::Invalid;
+
+            usize size = 0;
+            const char* p = data;
+            for (; p < lineEnd; ++p)
+            {
+                i32 digit = hexValue(*p);
+                if (digit < 0)
+                    break;
+
+                // Checked before shifting, so a long run of digits cannot wrap around
+                if (size > (_maxSize >> 4))
+                    return Status::TooLarge;
+                size = (size << 4) | static_cast<usize>(digit);
+            }
+
+            // At least one digit, then only optional whitespace and chunk extensions
+            if (p == data || (p < lineEnd && *p != ';' && *p != ' ' && *p != '\t'))
+                return Status::Invalid;
+
+            if (size > _maxSize - _decoded)
+                return Status::TooLarge;
+
+            consumed = (lineEnd + 2) - data;
+            _chunkRemaining = size;
+            _stage = size == 0 ? Stage::Trailers : Stage::Data;
+            return Status::Continue;
+        }
+
+        case Stage::Data:
+        {
+            usize n = std::min(len, _chunkRemaining);
+            if (n == 0)
+                return Status::NeedMore;
+
+            payload = std::string_view(data, n);
+            consumed = n;
+            _chunkRemaining -= n;
+            _decoded += n;
+            if (_chunkRemaining == 0)
+                _stage = Stage::DataEnd;
+            return Status::Continue;
+        }
+
+        case Stage::DataEnd:
+        {
+            if (len < 2)
+                return Status::NeedMore;
+            if (data[0] != '\r' || data[1] != '\n')
+                return Status::Invalid;
+
+            consumed = 2;
+            _stage = Stage::Size;
+            return Status::Continue;
+        }
+
+        case Stage::Trailers:
+        {
+            const char* lineEnd = StringUtils::find_crlf(data, end);
+            if (!lineEnd || lineEnd + 1 >= end)
+                return len > MAX_CHUNK_LINE_SIZE ? Status::Invalid : Status::NeedMore;
+            if (lineEnd[1] != '\n')
+                return Status::Invalid;
+
+            consumed = (lineEnd + 2) - data;
+            return lineEnd == data ? Status::Done : Status::Continue;
+        }
+    }
+
+    return Status::Invalid;
+}
@@ -0,0 +1,61 @@
+#ifndef CHUNKEDDECODER_H
+#define CHUNKEDDECODER_H
+
+#pragma once
+
+#include <ink/ink_base.hpp>
+#include <string_view>
+
+// Longest chunk-size line (size plus extensions) or trailer line accepted
+#define MAX_CHUNK_LINE_SIZE 1024
+
+/**
+ * @class ChunkedDecoder
+ * @brief Incremental decoder of a "Transfer-Encoding: chunked" body (RFC 9112 7.1).
+ *
+ * Fed arbitrary spans of the raw body, it consumes framing and hands back payload as
+ * views into the input, so callers can move it in place, copy it or stream it without
+ * the decoder owning any memory. Chunk extensions and trailer fields are skipped.
+ */
+class ChunkedDecoder
+{
+public:
+    enum class Status : u8 {
+        Continue = 0, // Consumed something, call again with the rest
+        NeedMore,     // The span ends inside a line, call again once more bytes arrived
+        Done,         // Last chunk and trailers consumed
+        Invalid,      // Malformed framing
+        TooLarge      // Decoded body would exceed the limit
+    };
+
+    /** @brief Starts a new body of at most @p maxSize decoded bytes. */
+    void reset(usize maxSize) noexcept
+    {
+        *this = ChunkedDecoder{};
+        _maxSize = maxSize;
+    }
+
+    /**
+     * @brief Decodes one step out of [data, data + len).
+     * @param consumed Raw bytes used, the caller advances by this much.
+     * @param payload Body bytes found in this step, a view into @p data, possibly empty.
+     */
+    Status decode(const char* data, usize len, usize& consumed, std::string_view& payload) noexcept;
+
+    usize decodedSize() const noexcept { return _decoded; }
+
+private:
+    enum class Stage : u8 {
+        Size = 0,
+        Data,
+        DataEnd,
+        Trailers
+    };
+
+    Stage _stage = Stage::Size;
+    usize _chunkRemaining = 0;
+    usize _decoded = 0;
+    usize _maxSize = 0;
+};
+
+#endif // CHUNKEDDECODER_H
@@ -32,40 +32,42 @@ std::string Conversions::urlEncode(std::string_view input)
 std::string Conversions::urlDecode(std::string_view input)
 {
     std::string result;
-    result.reserve(input.size());
+    result.resize(input.size());
+    result.resize(urlDecode(input, result.data()));
+    return result;
+}
 
-    static constexpr char hexval[256] = { /* lookup table for 0-9A-Fa-f -> 0-15 */
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,1,2,3,4,5,6,7,8,9,0,0,0,0,0,0,
-        10,11,12,13,14,15,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,10,11,12,13,14,15 // A-F
-    };
+static inline int hexDigit(char c) noexcept
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+size_t Conversions::urlDecode(std::string_view input, char* out) noexcept
+{
+    size_t n = 0;
 
     for (size_t i = 0; i < input.size(); ++i) {
-        if (input[i] == '%')
+        char c = input[i];
+        if (c == '%' && i + 2 < input.size())
         {
-            if (i + 2 < input.size())
+            int h1 = hexDigit(input[i + 1]);
+            int h2 = hexDigit(input[i + 2]);
+            if (h1 >= 0 && h2 >= 0)
             {
-                unsigned char h1 = hexval[static_cast<unsigned char>(input[++i])];
-                unsigned char h2 = hexval[static_cast<unsigned char>(input[++i])];
-                if (h1 < 16 && h2 < 16)
-                {
-                    result += static_cast<char>((h1 << 4) | h2);
-                    continue;
-                }
+                out[n++] = static_cast<char>((h1 << 4) | h2);
+                i += 2;
+                continue;
             }
         }
-        else if (input[i] == '+')
-        {
-            result += ' ';
-        }
-        else
-        {
-            result += input[i];
-        }
+
+        // Malformed escapes are kept as they are
+        out[n++] = (c == '+') ? ' ' : c;
     }
-    return result;
+
+    return n;
 }
 
 bool Conversions::iequals(std::string_view a, std::string_view b) noexcept
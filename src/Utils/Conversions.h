@@ -13,6 +13,13 @@ public:
     static std::string urlEncode(const std::string_view input);
     static std::string urlDecode(const std::string_view input);
 
+    /**
+     * @brief Percent-decodes @p input ('+' as space) into @p out without allocating.
+     * @param out Must hold at least input.size() bytes, decoding never grows the data.
+     * @return Bytes written to @p out.
+     */
+    static size_t urlDecode(const std::string_view input, char* out) noexcept;
+
     static bool iequals(std::string_view a, std::string_view b) noexcept;
 };
 
@@ -8,75 +8,205 @@
 #define UPGRADE_HEADER "Upgrade"
 #define WEBSOCKET_UPGRADE_HEADER "websocket"
 #define WS_VERSION_13_HEADER "13"
+#define CHUNKED_HEADER "chunked"
+#define CONTINUE_EXPECT_HEADER "100-continue"
 
 #include "WarpDefs.h"
 #include <array>
 #include <string_view>
 
 #define HEADER_LIST(X) \
-    X(Server, "Server", 0) \
-    X(ContentType, "Content-Type", 1) \
-    X(ContentLength, "Content-Length", 2) \
-    X(Connection, "Connection", 3) \
-    X(UserAgent, "User-Agent", 4) \
-    X(Accept, "Accept", 5) \
-    X(AcceptEncoding, "Accept-Encoding", 6) \
-    X(Host, "Host", 7) \
-    X(Authorization, "Authorization", 8) \
-    X(CacheControl, "Cache-Control", 9) \
-    X(Upgrade, "Upgrade", 10) \
-    X(SecWebSocketKey, "Sec-WebSocket-Key", 11) \
-    X(SecWebSocketVersion, "Sec-WebSocket-Version", 12) \
-    X(SecWebSocketAccept, "Sec-WebSocket-Accept", 13)
-
-enum WARP_API HeaderType : i32
-{
-    None = 0,
+    X(Server, "Server") \
+    X(ContentType, "Content-Type") \
+    X(ContentLength, "Content-Length") \
+    X(Connection, "Connection") \
+    X(UserAgent, "User-Agent") \
+    X(Accept, "Accept") \
+    X(AcceptEncoding, "Accept-Encoding") \
+    X(Host, "Host") \
+    X(Authorization, "Authorization") \
+    X(CacheControl, "Cache-Control") \
+    X(Upgrade, "Upgrade") \
+    X(SecWebSocketKey, "Sec-WebSocket-Key") \
+    X(SecWebSocketVersion, "Sec-WebSocket-Version") \
+    X(SecWebSocketAccept, "Sec-WebSocket-Accept") \
+    X(SecWebSocketExtensions, "Sec-WebSocket-Extensions") \
+    X(SecWebSocketProtocol, "Sec-WebSocket-Protocol") \
+    X(AcceptCharset, "Accept-Charset") \
+    X(AcceptLanguage, "Accept-Language") \
+    X(AcceptRanges, "Accept-Ranges") \
+    X(AccessControlAllowCredentials, "Access-Control-Allow-Credentials") \
+    X(AccessControlAllowHeaders, "Access-Control-Allow-Headers") \
+    X(AccessControlAllowMethods, "Access-Control-Allow-Methods") \
+    X(AccessControlAllowOrigin, "Access-Control-Allow-Origin") \
+    X(AccessControlExposeHeaders, "Access-Control-Expose-Headers") \
+    X(AccessControlRequestHeaders, "Access-Control-Request-Headers") \
+    X(AccessControlRequestMethod, "Access-Control-Request-Method") \
+    X(Age, "Age") \
+    X(Allow, "Allow") \
+    X(ContentDisposition, "Content-Disposition") \
+    X(ContentEncoding, "Content-Encoding") \
+    X(ContentLocation, "Content-Location") \
+    X(ContentRange, "Content-Range") \
+    X(Cookie, "Cookie") \
+    X(Date, "Date") \
+    X(ETag, "ETag") \
+    X(Expect, "Expect") \
+    X(Expires, "Expires") \
+    X(Forwarded, "Forwarded") \
+    X(IfMatch, "If-Match") \
+    X(IfModifiedSince, "If-Modified-Since") \
+    X(IfNoneMatch, "If-None-Match") \
+    X(IfUnmodifiedSince, "If-Unmodified-Since") \
+    X(KeepAlive, "Keep-Alive") \
+    X(LastModified, "Last-Modified") \
+    X(Link, "Link") \
+    X(Location, "Location") \
+    X(Origin, "Origin") \
+    X(ProxyAuthorization, "Proxy-Authorization") \
+    X(Range, "Range") \
+    X(Referer, "Referer") \
+    X(RetryAfter, "Retry-After") \
+    X(SetCookie, "Set-Cookie") \
+    X(StrictTransportSecurity, "Strict-Transport-Security") \
+    X(TE, "TE") \
+    X(Trailer, "Trailer") \
+    X(TransferEncoding, "Transfer-Encoding") \
+    X(Vary, "Vary") \
+    X(WWWAuthenticate, "WWW-Authenticate") \
+    X(XForwardedFor, "X-Forwarded-For") \
+    X(XForwardedHost, "X-Forwarded-Host") \
+    X(XForwardedProto, "X-Forwarded-Proto") \
+    X(XRequestId, "X-Request-Id")
 
-#define X(name, str, bit) name = (1 << bit),
+// Dense index of a known header, None doubles as the count
+enum WARP_API HeaderType : u8
+{
+#define X(name, str) name,
     HEADER_LIST(X)
 #undef X
+    None
 };
 
-constexpr std::array<std::string_view, 14> HeaderStrings = {
-#define X(name, str, bit) str,
+constexpr std::array<std::string_view, HeaderType::None> HeaderStrings = {
+#define X(name, str) str,
     HEADER_LIST(X)
 #undef X
 };
 
 #define MAX_HEADERS_SIZE HeaderStrings.size()
 
+// Headers that are not in HEADER_LIST, kept inline per request
+#define MAX_UNKNOWN_HEADERS 32
+
+// One bit per HeaderType
+typedef u64 HeaderMask;
+
+static_assert(HeaderType::None <= 64, "HEADER_LIST no longer fits in a HeaderMask");
+
+constexpr HeaderMask headerBit(HeaderType key)
+{
+    return HeaderMask(1) << key;
+}
+
+inline bool hasHeader(HeaderMask flags, HeaderMask required)
+{
+    return (flags & required) == required;
+}
+
 struct Header
 {
     HeaderType key;
     std::string_view value;
 };
 
-inline constexpr HeaderType operator|(HeaderType lhs, HeaderType rhs)
+struct UnknownHeader
 {
-    return static_cast<HeaderType>(
-        static_cast<i32>(lhs) |
-        static_cast<i32>(rhs)
-        );
+    std::string_view name;
+    std::string_view value;
+};
+
+/**
+ * @brief Compile-time perfect hash from a header name to its HeaderType.
+ *
+ * Names are hashed case-insensitively with a seeded FNV-1a into a 512 slot table.
+ * The seed is searched for at compile time until no two HEADER_LIST names share
+ * a slot, so classifying a name costs one hash and one case-insensitive compare.
+ */
+namespace header_hash {
+
+constexpr u32 kSlotBits = 9;
+constexpr u32 kSlots = 1u << kSlotBits;
+
+constexpr char lower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + 32) : c;
 }
 
-inline constexpr HeaderType operator&(HeaderType lhs, HeaderType rhs)
+constexpr u32 hash(const char* name, usize len, u32 seed)
 {
-    return static_cast<HeaderType>(
-        static_cast<i32>(lhs) &
-        static_cast<i32>(rhs)
-        );
+    u32 h = 2166136261u ^ seed;
+    for (usize i = 0; i < len; ++i)
+    {
+        h ^= static_cast<u8>(lower(name[i]));
+        h *= 16777619u;
+    }
+    return (h ^ (h >> 15)) >> (32 - kSlotBits);
 }
 
-inline HeaderType& operator|=(HeaderType& lhs, HeaderType rhs)
+struct Table
 {
-    lhs = lhs | rhs;
-    return lhs;
+    u32 seed = 0;
+    std::array<u8, kSlots> slots = {};
+};
+
+constexpr Table build()
+{
+    for (u32 seed = 1; seed < 100000; ++seed)
+    {
+        Table t;
+        t.seed = seed;
+        for (auto& s : t.slots) s = HeaderType::None;
+
+        bool collision = false;
+        for (u8 key = 0; key < HeaderType::None && !collision; ++key)
+        {
+            u32 slot = hash(HeaderStrings[key].data(), HeaderStrings[key].size(), seed);
+            if (t.slots[slot] != HeaderType::None)
+                collision = true;
+            else
+                t.slots[slot] = key;
+        }
+
+        if (!collision)
+            return t;
+    }
+    return Table{};
 }
 
-inline bool hasHeader(HeaderType flags, HeaderType required)
+inline constexpr Table kTable = build();
+static_assert(kTable.seed != 0, "No perfect hash seed found for HEADER_LIST");
+
+} // namespace header_hash
+
+/** @brief HeaderType of a header name, None if it is not in HEADER_LIST. */
+inline HeaderType classifyHeader(const char* name, usize len) noexcept
 {
-    return (flags & required) == required;
+    u8 key = header_hash::kTable.slots[header_hash::hash(name, len, header_hash::kTable.seed)];
+    if (key == HeaderType::None)
+        return HeaderType::None;
+
+    std::string_view known = HeaderStrings[key];
+    if (known.size() != len)
+        return HeaderType::None;
+
+    for (usize i = 0; i < len; ++i)
+    {
+        if (header_hash::lower(name[i]) != header_hash::lower(known[i]))
+            return HeaderType::None;
+    }
+
+    return static_cast<HeaderType>(key);
 }
 
 #endif // HEADERSLIST_H
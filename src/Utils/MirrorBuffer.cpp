@@ -0,0 +1,324 @@
+#include "MirrorBuffer.h"
+
+#include <ink/ink.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+MirrorBufferPool::~MirrorBufferPool()
+{
+    for (SizeClass& cls : _classes)
+    {
+        for (char* base : cls.slots)
+            munmap(base, cls.size * 2);
+        if (cls.fd >= 0)
+            close(cls.fd);
+    }
+}
+
+usize MirrorBufferPool::slotSize(usize size) noexcept
+{
+    static const usize page = static_cast<usize>(sysconf(_SC_PAGESIZE));
+    return std::max(page, (size + page - 1) / page * page);
+}
+
+MirrorBufferPool::SizeClass* MirrorBufferPool::sizeClass(usize size)
+{
+    // Sessions use one or two sizes, a linear scan beats any map
+    for (SizeClass& cls : _classes)
+    {
+        if (cls.size == size)
+            return &cls;
+    }
+
+    int fd = memfd_create("warp-mirror", MFD_CLOEXEC);
+    if (fd < 0)
+        return nullptr;
+
+    SizeClass cls;
+    cls.size = size;
+    cls.fd = fd;
+    _classes.push_back(std::move(cls));
+    return &_classes.back();
+}
+
+char* MirrorBufferPool::mapSlot(SizeClass& cls)
+{
+    off_t offset = static_cast<off_t>(cls.slotCount * cls.size);
+    if (ftruncate(cls.fd, offset + static_cast<off_t>(cls.size)) < 0)
+        return nullptr;
+
+    // Reserve the whole window first so both halves land back to back
+    void* window = mmap(nullptr, cls.size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (window == MAP_FAILED)
+        return nullptr;
+
+    char* base = static_cast<char*>(window);
+    if (mmap(base, cls.size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, cls.fd, offset) == MAP_FAILED ||
+        mmap(base + cls.size, cls.size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, cls.fd, offset) == MAP_FAILED)
+    {
+        munmap(window, cls.size * 2);
+        return nullptr;
+    }
+
+    cls.slotCount++;
+    cls.slots.push_back(base);
+    return base;
+}
+
+char* MirrorBufferPool::acquire(usize size)
+{
+    SizeClass* cls = sizeClass(size);
+
+    char* base = nullptr;
+    if (cls && !cls->free.empty())
+    {
+        base = cls->free.back();
+        cls->free.pop_back();
+        return base;
+    }
+
+    if (cls)
+        base = mapSlot(*cls);
+
+    if (!base && !_failureLogged)
+    {
+        // Typically vm.max_map_count: every slot costs two mappings
+        INK_WARN << "Mirrored buffer mapping failed, falling back to plain ring buffers: " << strerror(errno);
+        _failureLogged = true;
+    }
+
+    return base;
+}
+
+void MirrorBufferPool::release(char* base, usize size) noexcept
+{
+    SizeClass* cls = nullptr;
+    for (SizeClass& c : _classes)
+    {
+        if (c.size == size)
+            cls = &c;
+    }
+    if (!cls)
+        return;
+
+    // Past the warm set keep the mapping but give the pages back
+    if (cls->free.size() >= MIRROR_POOL_WARM_SLOTS)
+        madvise(base, size, MADV_REMOVE);
+
+    cls->free.push_back(base);
+}
+
+MirrorBuffer::MirrorBuffer(MirrorBufferPool& pool, usize capacity, SlabPool* overflow, usize overflowLimit) :
+    _capacity(MirrorBufferPool::slotSize(capacity)),
+    _overflow(overflow),
+    _overflowLimit(overflowLimit)
+{
+    _base = pool.acquire(_capacity);
+    if (_base)
+        _pool = &pool;
+    else
+        _base = new char[_capacity];
+}
+
+MirrorBuffer::~MirrorBuffer()
+{
+    for (usize i = _segmentHead; i < _segments.size(); ++i)
+        _overflow->release(_segments[i].data, _segments[i].cls);
+
+    if (_pool)
+        _pool->release(_base, _capacity);
+    else
+        delete[] _base;
+}
+
+char* MirrorBuffer::getWriteBuffer(usize& avail) noexcept
+{
+    usize w = writeOffset();
+    usize free = _capacity - _used - _held;
+    avail = _pool ? free : std::min(free, _capacity - w);
+    return _base + w;
+}
+
+const char* MirrorBuffer::getReadBuffer(usize& avail) const noexcept
+{
+    if (_used == 0 && _overflowUsed > 0)
+    {
+        const Segment& seg = _segments[_segmentHead];
+        avail = seg.write - seg.read;
+        return seg.data + seg.read;
+    }
+
+    avail = _pool ? _used : std::min(_used, _capacity - _read);
+    return _base + _read;
+}
+
+const char* MirrorBuffer::peek(usize offset, usize& avail) const noexcept
+{
+    if (offset < _used)
+    {
+        usize pos = _read + offset;
+        if (_pool)
+            avail = _used - offset;
+        else if (pos >= _capacity)
+            pos -= _capacity, avail = _used - offset;
+        else
+            avail = std::min(_used - offset, _capacity - pos);
+        return _base + pos;
+    }
+
+    // Ring bytes always come first, everything in the segments was written after them
+    offset -= _used;
+    for (usize i = _segmentHead; i < _segments.size(); ++i)
+    {
+        const Segment& seg = _segments[i];
+        usize len = seg.write - seg.read;
+        if (offset < len)
+        {
+            avail = len - offset;
+            return seg.data + seg.read + offset;
+        }
+        offset -= len;
+    }
+
+    avail = 0;
+    return nullptr;
+}
+
+void MirrorBuffer::advanceReadPos(usize n) noexcept
+{
+    usize fromRing = std::min(n, _used);
+    _used -= fromRing;
+    _read += fromRing;
+    if (_read >= _capacity)
+        _read -= _capacity;
+
+    if (_pins > 0)
+    {
+        usize unpinned = std::min(fromRing, _pinAhead);
+        _pinAhead -= unpinned;
+        _held += fromRing - unpinned;
+    }
+
+    // Empty: start over at the front, the next request does not wrap at all
+    if (_used == 0 && _held == 0)
+        _read = 0;
+
+    n -= fromRing;
+    while (n > 0 && _segmentHead < _segments.size())
+    {
+        Segment& seg = _segments[_segmentHead];
+        usize take = std::min(n, seg.write - seg.read);
+        seg.read += take;
+        _overflowUsed -= take;
+        n -= take;
+
+        if (seg.read < seg.write)
+            break;
+
+        _overflow->release(seg.data, seg.cls);
+        _overflowHeld -= seg.size;
+        _segmentHead++;
+    }
+
+    if (_segmentHead == _segments.size())
+    {
+        _segments.clear();
+        _segmentHead = 0;
+    }
+    else if (_segmentHead >= 64)
+    {
+        // A client that never catches up keeps the chain alive, drop the released entries now and then
+        _segments.erase(_segments.begin(), _segments.begin() + _segmentHead);
+        _segmentHead = 0;
+    }
+}
+
+void MirrorBuffer::pin(const char* data) noexcept
+{
+    // Later pins are further ahead, the first one already holds their bytes
+    if (_pins++ > 0)
+        return;
+
+    usize pos = static_cast<usize>(data - _base);
+    if (pos >= _capacity)
+        pos -= _capacity;
+
+    _pinAhead = pos >= _read ? pos - _read : pos + _capacity - _read;
+    _held = 0;
+}
+
+void MirrorBuffer::unpin() noexcept
+{
+    if (--_pins > 0)
+        return;
+
+    // No rewind to the front here, a recv may be writing behind the buffered bytes
+    _pinAhead = 0;
+    _held = 0;
+}
+
+usize MirrorBuffer::write(const char* data, usize len) noexcept
+{
+    // Segments hold the newest bytes, the ring may only take more once they drained
+    if (_overflowUsed > 0)
+        return writeSegments(data, len);
+
+    // A heap backed ring takes the part past its wrap point on the second pass
+    usize n = 0;
+    while (n < len)
+    {
+        usize avail;
+        char* dst = getWriteBuffer(avail);
+        if (avail == 0)
+            break;
+
+        usize k = std::min(len - n, avail);
+        std::memcpy(dst, data + n, k);
+        _used += k;
+        n += k;
+    }
+
+    if (n < len && _overflow)
+        n += writeSegments(data + n, len - n);
+
+    return n;
+}
+
+usize MirrorBuffer::writeSegments(const char* data, usize len) noexcept
+{
+    usize n = 0;
+    while (n < len)
+    {
+        if (_segmentHead == _segments.size() || _segments.back().write == _segments.back().size)
+        {
+            // Near the limit smaller blocks still fit what a large one would not
+            u32 cls = SlabPool::classFor(len - n);
+            while (cls > 0 && _overflowHeld + SlabPool::classSize(cls) > _overflowLimit)
+                cls--;
+            usize size = SlabPool::classSize(cls);
+            char* block = _overflowHeld + size <= _overflowLimit ? _overflow->acquire(cls) : nullptr;
+            if (!block)
+            {
+                _truncated = true;
+                break;
+            }
+
+            _segments.push_back(Segment{block, cls, size, 0, 0});
+            _overflowHeld += size;
+        }
+
+        Segment& seg = _segments.back();
+        usize k = std::min(len - n, seg.size - seg.write);
+        std::memcpy(seg.data + seg.write, data + n, k);
+        seg.write += k;
+        _overflowUsed += k;
+        n += k;
+    }
+
+    return n;
+}
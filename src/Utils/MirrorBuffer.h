@@ -0,0 +1,162 @@
+#ifndef MIRRORBUFFER_H
+#define MIRRORBUFFER_H
+
+#pragma once
+
+#include <ink/ink_base.hpp>
+#include <vector>
+
+#include "SlabPool.h"
+
+// Free mirror slots kept with their pages per size class, the memory of extra ones is returned
+#define MIRROR_POOL_WARM_SLOTS 1024
+
+/**
+ * @class MirrorBufferPool
+ * @brief Per-worker source of double-mapped buffers.
+ *
+ * Every slot is a window of 2 * size bytes of address space whose two halves map the
+ * same size bytes of a memfd, so a ring living in the first half can be read or written
+ * past its end without wrapping. Each size class shares one memfd, grown a slot at a
+ * time, and slots are recycled rather than unmapped. Worker thread only.
+ */
+class MirrorBufferPool
+{
+public:
+    MirrorBufferPool() = default;
+    ~MirrorBufferPool();
+
+    MirrorBufferPool(const MirrorBufferPool&) = delete;
+    MirrorBufferPool& operator=(const MirrorBufferPool&) = delete;
+
+    /** @brief @p size rounded up to whole pages, the only sizes acquire() hands out. */
+    static usize slotSize(usize size) noexcept;
+
+    /**
+     * @param size A slotSize() value.
+     * @return Start of the mirrored window, nullptr if the mapping failed (logged once).
+     */
+    char* acquire(usize size);
+
+    void release(char* base, usize size) noexcept;
+
+private:
+    struct SizeClass {
+        usize size = 0;
+        int fd = -1;
+        usize slotCount = 0;
+        std::vector<char*> slots; // Every window, for the final unmap
+        std::vector<char*> free;
+    };
+
+    SizeClass* sizeClass(usize size);
+    char* mapSlot(SizeClass& cls);
+
+    std::vector<SizeClass> _classes;
+    bool _failureLogged = false;
+};
+
+/**
+ * @class MirrorBuffer
+ * @brief Session read/write ring whose readable and writable regions are always contiguous.
+ *
+ * Backed by a MirrorBufferPool slot: getReadBuffer() returns everything buffered and
+ * getWriteBuffer() all free space, even across the wrap point. If no slot can be mapped
+ * it degrades to a plain heap ring, which like any ring only exposes the contiguous part.
+ *
+ * Write buffers may also chain SlabPool blocks: what write() cannot fit in the ring goes
+ * to segments behind it, up to an overflow limit, and every write after that follows
+ * them until they drained. Past the limit the write is cut short and truncated() is set.
+ */
+class MirrorBuffer
+{
+public:
+    /**
+     * @param capacity Rounded up to whole pages.
+     * @param overflow Source of segments past the ring, null for a fixed size buffer.
+     * @param overflowLimit Segment bytes this buffer may hold at once.
+     */
+    MirrorBuffer(MirrorBufferPool& pool, usize capacity, SlabPool* overflow = nullptr, usize overflowLimit = 0);
+    ~MirrorBuffer();
+
+    MirrorBuffer(const MirrorBuffer&) = delete;
+    MirrorBuffer& operator=(const MirrorBuffer&) = delete;
+
+    /** @brief Free space of the ring, segments are only ever filled through write(). */
+    char* getWriteBuffer(usize& avail) noexcept;
+    /** @brief Contiguous start of the buffered bytes: the ring's, or the first segment's once the ring is empty. */
+    const char* getReadBuffer(usize& avail) const noexcept;
+
+    /** @brief Contiguous run of buffered bytes starting @p offset bytes in, @p avail 0 past the end. */
+    const char* peek(usize offset, usize& avail) const noexcept;
+
+    void advanceWritePos(usize n) noexcept { _used += n; }
+    void advanceReadPos(usize n) noexcept;
+
+    /** @brief Copies as much of @p data as fits, in the ring or in segments. @return Bytes copied. */
+    usize write(const char* data, usize len) noexcept;
+
+    usize size() const noexcept { return _used + _overflowUsed; }
+    usize capacity() const noexcept { return _capacity; }
+    bool isMirrored() const noexcept { return _pool != nullptr; }
+
+    /** @brief Some bytes spilled into segments. */
+    bool isSegmented() const noexcept { return _overflowUsed > 0; }
+
+    /** @brief A write() was cut short because the overflow limit or the worker's SlabPool cap was hit. */
+    bool truncated() const noexcept { return _truncated; }
+
+    /** @brief Memory the ring bytes are read from, both halves of a mirrored window. */
+    const char* begin() const noexcept { return _base; }
+    const char* end() const noexcept { return _base + (_pool ? 2 * _capacity : _capacity); }
+
+    /**
+     * @brief Keeps the ring bytes from @p data on from being written over once they were read,
+     *        for a send still reading them in place. Held until the matching unpin(); while
+     *        several pins are taken the bytes from the first one on stay held until the last goes.
+     * @param data Inside the buffered ring bytes.
+     */
+    void pin(const char* data) noexcept;
+    void unpin() noexcept;
+
+    bool isPinned() const noexcept { return _pins > 0; }
+
+private:
+    struct Segment {
+        char* data;
+        u32 cls;
+        usize size;
+        usize read;
+        usize write;
+    };
+
+    /** @brief Appends to the segment chain. @return Bytes copied. */
+    usize writeSegments(const char* data, usize len) noexcept;
+
+
+    usize writeOffset() const noexcept
+    {
+        usize w = _read + _used;
+        return w >= _capacity ? w - _capacity : w;
+    }
+
+    MirrorBufferPool* _pool = nullptr; // Null when heap backed
+    char* _base = nullptr;
+    usize _capacity = 0;
+    usize _read = 0;
+    usize _used = 0;
+
+    u32 _pins = 0;
+    usize _pinAhead = 0; // Unread bytes in front of the first pinned one
+    usize _held = 0;     // Read bytes behind _read kept for the pins
+
+    SlabPool* _overflow = nullptr;
+    usize _overflowLimit = 0;
+    std::vector<Segment> _segments;
+    usize _segmentHead = 0;   // First undrained segment
+    usize _overflowUsed = 0;  // Bytes buffered in segments
+    usize _overflowHeld = 0;  // Block bytes held, counted against the overflow limit
+    bool _truncated = false;
+};
+
+#endif // MIRRORBUFFER_H
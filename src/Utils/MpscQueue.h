@@ -0,0 +1,102 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#pragma once
+
+#include <ink/ink_base.hpp>
+#include <atomic>
+#include <memory>
+
+/**
+ * @class MpscQueue
+ * @brief Bounded lock-free queue, many producers and a single consumer.
+ *
+ * Every slot carries a sequence number telling producers whether it is free and the
+ * consumer whether it was published (Vyukov's bounded queue). push() never blocks and
+ * fails when the queue is full, pop() must only ever be called from the owning thread.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+    /** @param capacity Rounded up to the next power of two. */
+    explicit MpscQueue(usize capacity)
+    {
+        usize size = 1;
+        while (size < capacity) size <<= 1;
+
+        _mask = size - 1;
+        _slots = std::make_unique<Slot[]>(size);
+        for (usize i = 0; i < size; ++i)
+            _slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    /** @brief Safe from any thread. @return false if the queue is full. */
+    bool push(T value) noexcept
+    {
+        usize pos = _tail.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot& slot = _slots[pos & _mask];
+            usize seq = slot.seq.load(std::memory_order_acquire);
+            isize diff = static_cast<isize>(seq) - static_cast<isize>(pos);
+
+            if (diff == 0)
+            {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.value = std::move(value);
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** @brief Consumer thread only. @return false if nothing was published yet. */
+    bool pop(T& out) noexcept
+    {
+        Slot& slot = _slots[_head & _mask];
+        usize seq = slot.seq.load(std::memory_order_acquire);
+        if (static_cast<isize>(seq) - static_cast<isize>(_head + 1) < 0)
+            return false;
+
+        out = std::move(slot.value);
+        slot.seq.store(_head + _mask + 1, std::memory_order_release);
+        ++_head;
+        return true;
+    }
+
+    /** @brief Consumer thread only. True if pop() would fail right now. */
+    bool empty() const noexcept
+    {
+        const Slot& slot = _slots[_head & _mask];
+        return static_cast<isize>(slot.seq.load(std::memory_order_acquire)) - static_cast<isize>(_head + 1) < 0;
+    }
+
+private:
+    struct Slot {
+        std::atomic<usize> seq;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> _slots;
+    usize _mask = 0;
+
+    // Producers and the consumer hammer different cache lines
+    alignas(64) std::atomic<usize> _tail{0};
+    alignas(64) usize _head = 0;
+};
+
+#endif // MPSCQUEUE_H
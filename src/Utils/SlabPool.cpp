@@ -0,0 +1,44 @@
+#include "SlabPool.h"
+
+#include <algorithm>
+
+SlabPool::~SlabPool()
+{
+    for (std::vector<char*>& blocks : _free)
+    {
+        for (char* block : blocks)
+            delete[] block;
+    }
+}
+
+char* SlabPool::acquire(u32 cls)
+{
+    usize bytes = classSize(cls);
+    if (_limit && _inUse + bytes > _limit)
+        return nullptr;
+
+    char* block;
+    if (!_free[cls].empty())
+    {
+        block = _free[cls].back();
+        _free[cls].pop_back();
+    }
+    else
+    {
+        block = new char[bytes];
+    }
+
+    _inUse += bytes;
+    _peak = std::max(_peak, _inUse);
+    return block;
+}
+
+void SlabPool::release(char* block, u32 cls) noexcept
+{
+    _inUse -= classSize(cls);
+
+    if (_free[cls].size() < SLAB_IDLE_BLOCKS)
+        _free[cls].push_back(block);
+    else
+        delete[] block;
+}
@@ -0,0 +1,59 @@
+#ifndef SLABPOOL_H
+#define SLABPOOL_H
+
+#pragma once
+
+#include <ink/ink_base.hpp>
+#include <vector>
+
+#define SLAB_CLASS_COUNT 3
+// Free blocks kept per class for reuse, the rest goes back to the heap
+#define SLAB_IDLE_BLOCKS 256
+
+/**
+ * @class SlabPool
+ * @brief Per-worker 4, 16 and 64 KB blocks that write buffers chain on when their ring is full.
+ *
+ * Blocks are recycled through one free list per class. The bytes handed out are capped,
+ * so a few connections that never read cannot take the worker's memory. Worker thread only.
+ */
+class SlabPool
+{
+public:
+    SlabPool() = default;
+    ~SlabPool();
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    static constexpr usize classSize(u32 cls) noexcept { return usize(4096) << (2 * cls); }
+
+    /** @brief Smallest class holding @p size bytes, the largest one when none does. */
+    static u32 classFor(usize size) noexcept
+    {
+        u32 cls = 0;
+        while (cls + 1 < SLAB_CLASS_COUNT && classSize(cls) < size)
+            cls++;
+        return cls;
+    }
+
+    /** @brief Caps the bytes of all blocks handed out at once, 0 for no cap. */
+    void setLimit(usize limit) noexcept { _limit = limit; }
+
+    /** @return A block of classSize(@p cls) bytes, nullptr when the limit would be exceeded. */
+    char* acquire(u32 cls);
+
+    void release(char* block, u32 cls) noexcept;
+
+    /** @brief Bytes of the blocks currently handed out. */
+    usize inUse() const noexcept { return _inUse; }
+    usize peakInUse() const noexcept { return _peak; }
+
+private:
+    std::vector<char*> _free[SLAB_CLASS_COUNT];
+    usize _inUse = 0;
+    usize _peak = 0;
+    usize _limit = 0;
+};
+
+#endif // SLABPOOL_H
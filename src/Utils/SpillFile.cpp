@@ -0,0 +1,95 @@
+#include "SpillFile.h"
+
+#include <ink/ink.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+SpillFile::~SpillFile()
+{
+    close();
+}
+
+bool SpillFile::open(const std::string& dir)
+{
+    close();
+
+    _fd = ::open(dir.c_str(), O_TMPFILE | O_RDWR | O_EXCL | O_CLOEXEC, 0600);
+
+    // O_TMPFILE needs filesystem support, fall back to a named file unlinked at once
+    if (_fd < 0 && (errno == EOPNOTSUPP || errno == EISDIR))
+    {
+        std::string path = dir + "/warp-body-XXXXXX";
+        _fd = mkostemp(path.data(), O_CLOEXEC);
+        if (_fd >= 0)
+            unlink(path.c_str());
+    }
+
+    if (_fd < 0)
+    {
+        INK_ERROR << "Failed to create spill file in " << dir << ": " << strerror(errno);
+        return false;
+    }
+
+    return true;
+}
+
+bool SpillFile::append(const char* data, usize len)
+{
+    while (len > 0)
+    {
+        ssize_t n = ::write(_fd, data, len);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            INK_ERROR << "Spill file write failed: " << strerror(errno);
+            return false;
+        }
+
+        data += n;
+        len -= n;
+        _size += n;
+    }
+
+    return true;
+}
+
+std::string_view SpillFile::map()
+{
+    if (_size == 0)
+        return {};
+
+    if (!_map)
+    {
+        void* addr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            INK_ERROR << "Spill file mmap failed: " << strerror(errno);
+            return {};
+        }
+
+        _map = addr;
+    }
+
+    return std::string_view(static_cast<const char*>(_map), _size);
+}
+
+void SpillFile::close() noexcept
+{
+    if (_map)
+    {
+        munmap(_map, _size);
+        _map = nullptr;
+    }
+
+    if (_fd >= 0)
+    {
+        ::close(_fd);
+        _fd = -1;
+    }
+
+    _size = 0;
+}
@@ -0,0 +1,48 @@
+#ifndef SPILLFILE_H
+#define SPILLFILE_H
+
+#pragma once
+
+#include <ink/ink_base.hpp>
+#include <string>
+#include <string_view>
+
+/**
+ * @class SpillFile
+ * @brief Anonymous temp file a large request body is appended to, then mapped read-only.
+ *
+ * The file is created with O_TMPFILE (or unlinked right after mkstemp), so it never shows
+ * up in the directory and disappears with the last descriptor. Its pages live in the page
+ * cache, not in the session, which keeps the memory a large upload pins bounded.
+ */
+class SpillFile
+{
+public:
+    SpillFile() = default;
+    ~SpillFile();
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    /** @brief Creates the file in @p dir. @return false on failure, logged. */
+    bool open(const std::string& dir);
+
+    /** @return false if the write failed, logged. */
+    bool append(const char* data, usize len);
+
+    /** @brief Maps everything appended so far, valid until close(). */
+    std::string_view map();
+
+    /** @brief Unmaps and drops the file. */
+    void close() noexcept;
+
+    bool isOpen() const noexcept { return _fd >= 0; }
+    usize size() const noexcept { return _size; }
+
+private:
+    int _fd = -1;
+    usize _size = 0;
+    void* _map = nullptr;
+};
+
+#endif // SPILLFILE_H
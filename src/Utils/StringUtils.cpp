@@ -4,6 +4,52 @@
 #include <ink/utils.h>
 #include <emmintrin.h>
 
+// The tokenizer is picked at compile time, release builds use -march=native.
+// AVX2 scans 32 bytes per step, SSE4.2 uses PCMPESTRI for the field name ranges,
+// SSE2 covers the rest in 16-byte steps and everything has a scalar tail.
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Byte terminates a field name: CTL (0x00-0x1F), SP or DEL
+inline bool isFieldNameStop(char c) noexcept
+{
+    u8 b = static_cast<u8>(c);
+    return b <= 0x20 || b == 0x7F;
+}
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP)
+// Bits set for every byte of @p v that is a CTL, SP, DEL or ':'
+inline u32 fieldStopMask16(__m128i v) noexcept
+{
+    // Signed compare, so bytes >= 0x80 (negative) are masked out again below
+    __m128i low = _mm_cmpgt_epi8(_mm_set1_epi8(0x21), v);
+    __m128i negative = _mm_cmpgt_epi8(_mm_setzero_si128(), v);
+    __m128i ctl = _mm_andnot_si128(negative, low);
+    __m128i del = _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7F));
+    __m128i colon = _mm_cmpeq_epi8(v, _mm_set1_epi8(':'));
+    return static_cast<u32>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(ctl, del), colon)));
+}
+#endif
+
+#if defined(__AVX2__)
+// Same as fieldStopMask16, 32 bytes at a time
+inline u32 fieldStopMask32(__m256i v) noexcept
+{
+    // Signed compare, so bytes >= 0x80 (negative) are masked out again below
+    __m256i low = _mm256_cmpgt_epi8(_mm256_set1_epi8(0x21), v);
+    __m256i negative = _mm256_cmpgt_epi8(_mm256_setzero_si256(), v);
+    __m256i ctl = _mm256_andnot_si256(negative, low);
+    __m256i del = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7F));
+    __m256i colon = _mm256_cmpeq_epi8(v, _mm256_set1_epi8(':'));
+    return static_cast<u32>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(ctl, del), colon)));
+}
+#endif
+
+} // namespace
+
 StringUtils::StringUtils() {}
 
 u32 StringUtils::hashStr(const char* str, size_t len) noexcept
@@ -22,6 +68,21 @@ const char* StringUtils::find_crlf(const char* data, const char* end) noexcept
 {
     const char* p = data;
 
+#if defined(__AVX2__)
+    if (end - p >= 32) {
+        const __m256i cr = _mm256_set1_epi8('\r');
+
+        while (end - p >= 32) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            u32 mask = static_cast<u32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, cr)));
+            if (mask) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 32;
+        }
+    }
+#endif
+
 #if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP)
     if (end - p >= 16) {
         const __m128i cr = _mm_set1_epi8('\r');
@@ -51,6 +112,143 @@ const char* StringUtils::find_crlf(const char* data, const char* end) noexcept
     return nullptr;
 }
 
+const char* StringUtils::find_char(const char* data, const char* end, char c) noexcept
+{
+    const char* p = data;
+
+#if defined(__AVX2__)
+    const __m256i needle32 = _mm256_set1_epi8(c);
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        u32 mask = static_cast<u32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle32)));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP)
+    const __m128i needle = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+
+    // Scalar tail
+    while (p < end) {
+        if (*p == c)
+            return p;
+        ++p;
+    }
+
+    return nullptr;
+}
+
+const char* StringUtils::find_either(const char* data, const char* end, char a, char b) noexcept
+{
+    const char* p = data;
+
+#if defined(__AVX2__)
+    const __m256i a32 = _mm256_set1_epi8(a);
+    const __m256i b32 = _mm256_set1_epi8(b);
+    while (end - p >= 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, a32), _mm256_cmpeq_epi8(chunk, b32));
+        u32 mask = static_cast<u32>(_mm256_movemask_epi8(hit));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 32;
+    }
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP)
+    const __m128i a16 = _mm_set1_epi8(a);
+    const __m128i b16 = _mm_set1_epi8(b);
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, a16), _mm_cmpeq_epi8(chunk, b16)));
+        if (mask) return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#endif
+
+    // Scalar tail
+    while (p < end) {
+        if (*p == a || *p == b)
+            return p;
+        ++p;
+    }
+
+    return nullptr;
+}
+
+const char* StringUtils::find_field_colon(const char* data, const char* end) noexcept
+{
+    const char* p = data;
+
+#if defined(__AVX2__)
+    while (end - p >= 32) {
+        u32 mask = fieldStopMask32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+        if (mask) {
+            p += __builtin_ctz(mask);
+            return *p == ':' ? p : nullptr;
+        }
+        p += 32;
+    }
+#endif
+
+#if defined(__SSE4_2__) && !defined(__AVX2__)
+    // Byte ranges a field name stops at: CTL and SP, DEL, ':'
+    alignas(16) static const char stopRanges[16] = { '\x00', '\x20', '\x7F', '\x7F', ':', ':' };
+    const __m128i ranges = _mm_load_si128(reinterpret_cast<const __m128i*>(stopRanges));
+
+    while (end - p >= 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int idx = _mm_cmpestri(ranges, 6, chunk, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_LEAST_SIGNIFICANT);
+        if (idx != 16) {
+            p += idx;
+            return *p == ':' ? p : nullptr;
+        }
+        p += 16;
+    }
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP)
+    // Field names are mostly shorter than 32 bytes, the AVX2 loop rarely gets to run
+    while (end - p >= 16) {
+        u32 mask = fieldStopMask16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+        if (mask) {
+            p += __builtin_ctz(mask);
+            return *p == ':' ? p : nullptr;
+        }
+        p += 16;
+    }
+#endif
+
+    // Scalar tail
+    while (p < end) {
+        if (*p == ':')
+            return p;
+        if (isFieldNameStop(*p))
+            return nullptr;
+        ++p;
+    }
+
+    return nullptr;
+}
+
+const char* StringUtils::simd_level() noexcept
+{
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE4_2__)
+    return "SSE4.2";
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86_FP)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
 bool StringUtils::is_crlf(const char* p, const char* end) noexcept
 {
     return (p + 1 < end) && (p[0] == '\r') && (p[1] == '\n');
@@ -13,6 +13,22 @@ public:
 
     static const char* find_crlf(const char* data, const char* end) noexcept;
 
+    /** @brief First @p c in [data, end), nullptr if absent. */
+    static const char* find_char(const char* data, const char* end, char c) noexcept;
+
+    /** @brief First @p a or @p b in [data, end), nullptr if absent. */
+    static const char* find_either(const char* data, const char* end, char a, char b) noexcept;
+
+    /**
+     * @brief Scans a header field name for its ':'.
+     * @return The ':', or nullptr if a control character, space or DEL comes first
+     *         (not allowed in a field name token) or the line has no ':' at all.
+     */
+    static const char* find_field_colon(const char* data, const char* end) noexcept;
+
+    /** @brief Instruction set the tokenizer functions above were built for. */
+    static const char* simd_level() noexcept;
+
     static bool is_crlf(const char* p, const char* end) noexcept;
 
     static bool is_header_end(const char* p, const char* end) noexcept;
@@ -20,13 +20,17 @@ typedef int socket_t;
 
 #define WARP_API
 
-#ifdef USE_EPOLL
 #define MAX_EVENTS 8192
-#endif
 
 #define TIMERWHELL_TICK_INTERVAL 1000 // 1 sec
 #define SESSION_POOL_SIZE 32*1024
+#define HANDOFF_QUEUE_SIZE 4096
+#define MAILBOX_SIZE 4096
+#define MAILBOX_DRAIN_BATCH 256 // Tasks run per loop iteration before going back to I/O
+#define REQUEST_ARENA_BLOCK_SIZE 8*1024 // Per session, taken on first use
 #define MIN_REQUEST_SIZE 16
+#define BORROWED_BODY_MIN_SIZE 4096 // Smaller bodies are copied into the write buffer, an extra iovec costs more
+#define SEND_IOV_MAX 8
 
 #define HTTP_VERSION "HTTP/1.1"
 
@@ -88,6 +92,7 @@ enum WARP_API StatusCode : u32 {
     range_not_satisfiable = 416,
     expectation_failed = 417,
     too_many_requests = 429,
+    request_header_fields_too_large = 431,
 
     // 5xx Server Errors
     internal_server_error = 500,
@@ -106,6 +111,8 @@ class WARP_API HttpServer;
 class WARP_API WebSocketContext;
 
 using RequestHandler = std::function<void(const HttpRequest&, HttpResponse&)>;
+// Body bytes of a streaming endpoint as they arrive, return false to reject the request
+using BodyChunkHandler = std::function<bool(const HttpRequest&, std::string_view)>;
 using WebSocketOpenHandler = std::function<void(WebSocketContext&)>;
 using WebSocketMessageHandler = std::function<void(WebSocketContext&, std::string_view)>;
 using WebSocketCloseHandler = std::function<void(WebSocketContext&)>;
@@ -121,7 +128,33 @@ struct WARP_API WebSocketRoute {
     WebSocketCloseHandler onClose;
 };
 
-#ifdef USE_IOURING
+// How an endpoint receives request bodies
+enum class BodyMode : u8 {
+    Buffered = 0, // Whole body in the read buffer, up to max_body_size
+    Stream,       // Chunks handed to a BodyChunkHandler as they arrive, up to max_upload_size
+    Spill         // Written to a temp file and mapped for the handler, up to max_upload_size
+};
+
+// Event loop implementation driving the sessions, resolved once at startup
+enum class IoBackend : u8 {
+    Auto = 0, // io_uring when the running kernel passes the feature probe, epoll otherwise
+    Epoll,
+    IoUring
+};
+
+// Who accepts connections
+enum class AcceptMode : u8 {
+    ReusePort = 0, // Every worker accepts on its own SO_REUSEPORT listener
+    Central        // One acceptor thread hands each connection to the least loaded worker
+};
+
+// How each worker's io_uring instance is set up
+enum class RingSetupMode : u8 {
+    SqPollPerWorker = 0, // One SQPOLL kernel thread per worker, all of them bound to CPU 0
+    SharedSqPoll,        // One SQPOLL kernel thread shared by all workers (IORING_SETUP_ATTACH_WQ)
+    DeferTaskrun         // No SQ thread, SINGLE_ISSUER | DEFER_TASKRUN | COOP_TASKRUN, batched submit_and_wait
+};
+
 enum WARP_API OperationType : u8 {
     Read = 0,
     Write
@@ -148,6 +181,5 @@ struct WARP_API IoRequest {
     Session* session;
     OperationType optype;
 };
-#endif
 
 #endif // WARPDEFS_H
@@ -0,0 +1,176 @@
+// ChunkedDecoder fed complete bodies and bodies growing a few bytes at a time, as a read
+// buffer fills up, plus the in-place compaction the session runs over its payload views.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "Utils/ChunkedDecoder.h"
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            return false;                                                   \
+        }                                                                   \
+    } while (0)
+
+using Status = ChunkedDecoder::Status;
+
+static const std::string FRAMED =
+    "4\r\nWiki\r\n"
+    "6;name=value\r\npedia \r\n"
+    "e \r\nin \r\n\r\nchunks.\r\n"
+    "0\r\nX-Trailer: 1\r\nX-Other: 2\r\n\r\n";
+static const std::string DECODED = "Wikipedia in \r\n\r\nchunks.";
+
+struct Result {
+    Status status;
+    std::string payload;
+    usize consumed; // Raw bytes the decoder used up
+};
+
+/**
+ * @brief Decodes @p raw, offering the decoder @p piece more bytes each time it needs more,
+ *        the way a session calls it again once the next read arrived.
+ */
+static Result decodeAll(const std::string& raw, usize piece, usize maxSize = 1024)
+{
+    ChunkedDecoder decoder;
+    decoder.reset(maxSize);
+
+    Result result{Status::NeedMore, {}, 0};
+    usize avail = std::min(piece, raw.size());
+    while (true)
+    {
+        usize used;
+        std::string_view payload;
+        result.status = decoder.decode(raw.data() + result.consumed, avail - result.consumed, used, payload);
+        result.payload.append(payload);
+        result.consumed += used;
+
+        if (result.status == Status::Continue)
+            continue;
+        if (result.status != Status::NeedMore || avail == raw.size())
+            return result;
+
+        avail = std::min(avail + piece, raw.size());
+    }
+}
+
+static bool validBody()
+{
+    for (usize piece = 1; piece <= FRAMED.size(); ++piece)
+    {
+        Result result = decodeAll(FRAMED + "GET /next", piece);
+        CHECK(result.status == Status::Done);
+        CHECK(result.payload == DECODED);
+        CHECK(result.consumed == FRAMED.size());
+    }
+
+    // Uppercase digits, leading zeros, an empty body
+    CHECK(decodeAll("00A\r\n0123456789\r\n0\r\n\r\n", 3).payload == "0123456789");
+    CHECK(decodeAll("0\r\n\r\n", 1).status == Status::Done);
+    return true;
+}
+
+static bool incompleteBody()
+{
+    const char* prefixes[] = {"", "4", "4\r", "4\r\nWi", "4\r\nWiki", "4\r\nWiki\r", "4\r\nWiki\r\n0\r\n", "4\r\nWiki\r\n0\r\nX: 1\r\n"};
+    for (const char* prefix : prefixes)
+        CHECK(decodeAll(prefix, 1).status == Status::NeedMore);
+    return true;
+}
+
+static bool malformedBody()
+{
+    const char* invalid[] = {
+        "zz\r\n",             // Not hex
+        "\r\n",               // No digits
+        ";ext\r\n",           // Extension without a size
+        "-4\r\nabcd\r\n",     // Sign
+        "0x4\r\nabcd\r\n",    // Prefix
+        "4x\r\nabcd\r\n",     // Junk after the digits
+        "4\r\nabcdef\r\n",    // Data longer than the size
+        "4\r\nabcd\n0\r\n\r\n", // Bare LF after the data
+        "0\r\nX: 1\r\r\n",    // CR without LF in the trailers
+    };
+    for (const char* raw : invalid)
+    {
+        for (usize piece : {usize(1), usize(1024)})
+            CHECK(decodeAll(raw, piece).status == Status::Invalid);
+    }
+
+    // A size line or trailer that never ends
+    CHECK(decodeAll("4" + std::string(MAX_CHUNK_LINE_SIZE + 1, ';'), 64).status == Status::Invalid);
+    CHECK(decodeAll("0\r\nX: " + std::string(MAX_CHUNK_LINE_SIZE, 'a'), 64).status == Status::Invalid);
+    return true;
+}
+
+static bool limits()
+{
+    CHECK(decodeAll("10\r\n0123456789abcdef\r\n0\r\n\r\n", 5, 16).status == Status::Done);
+    CHECK(decodeAll("11\r\n", 5, 16).status == Status::TooLarge);
+
+    // The limit counts across chunks
+    CHECK(decodeAll("8\r\n01234567\r\n9\r\n", 5, 16).status == Status::TooLarge);
+
+    // Enough digits to wrap a 64-bit size around
+    CHECK(decodeAll("10000000000000001\r\n", 64, ~usize(0)).status == Status::TooLarge);
+    CHECK(decodeAll("ffffffffffffffffffff\r\n", 64).status == Status::TooLarge);
+    return true;
+}
+
+static bool inPlace()
+{
+    // As the session does: each payload piece is moved down over the framing before it
+    for (usize piece = 1; piece <= FRAMED.size(); ++piece)
+    {
+        std::string buffer = FRAMED;
+        char* body = buffer.data();
+        usize rawPos = 0;
+        usize avail = std::min(piece, buffer.size());
+
+        ChunkedDecoder decoder;
+        decoder.reset(1024);
+
+        Status status;
+        while (true)
+        {
+            usize used;
+            std::string_view payload;
+            status = decoder.decode(body + rawPos, avail - rawPos, used, payload);
+            if (!payload.empty())
+                std::memmove(body + decoder.decodedSize() - payload.size(), payload.data(), payload.size());
+            rawPos += used;
+
+            if (status == Status::Continue)
+                continue;
+            if (status != Status::NeedMore || avail == buffer.size())
+                break;
+            avail = std::min(avail + piece, buffer.size());
+        }
+
+        CHECK(status == Status::Done);
+        CHECK(decoder.decodedSize() == DECODED.size());
+        CHECK(std::string_view(body, decoder.decodedSize()) == DECODED);
+    }
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+    ok &= validBody();
+    ok &= incompleteBody();
+    ok &= malformedBody();
+    ok &= limits();
+    ok &= inPlace();
+
+    if (!ok)
+        return 1;
+
+    std::puts("ChunkedDecoderTest passed");
+    return 0;
+}
@@ -0,0 +1,338 @@
+// Request parsing through a real epoll Session on a socketpair: requests split at every
+// byte, pipelined requests, chunked bodies whose framing is cut across reads, malformed
+// chunk sizes, and the 100 Continue interim response of Expect: 100-continue.
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <ink/ink.hpp>
+
+#include "EventLoop/WorkerContext.h"
+#include "Managers/EndpointManager.h"
+#include "Response/HttpResponse.h"
+#include "Server/Session.h"
+#include "Settings/Settings.h"
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            return false;                                                   \
+        }                                                                   \
+    } while (0)
+
+static const std::string CHUNKED_BODY =
+    "4\r\nWiki\r\n"
+    "6;name=value\r\npedia \r\n"
+    "E\r\nin \r\n\r\nchunks.\r\n"
+    "0\r\nX-Trailer: 1\r\n\r\n";
+static const std::string DECODED_BODY = "Wikipedia in \r\n\r\nchunks.";
+
+struct Response {
+    std::string status; // "200", "400"...
+    std::string body;
+};
+
+static void registerEndpoints()
+{
+    Endpoint* echo = new Endpoint("/echo", Method::POST);
+    echo->setHandlerCallback([](const HttpRequest& request, HttpResponse& response) {
+        response.setBody(std::string(request.path()) + ":" + std::string(request.body()));
+    });
+    EndpointManager::getInstance()->registerEndpoint(echo);
+
+    Endpoint* hello = new Endpoint("/hello", Method::GET);
+    hello->setHandlerCallback([](const HttpRequest& request, HttpResponse& response) {
+        response.setBody("hi " + std::string(request.query()));
+    });
+    EndpointManager::getInstance()->registerEndpoint(hello);
+}
+
+static std::string post(const std::string& body)
+{
+    return "POST /echo HTTP/1.1\r\nHost: localhost\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+static std::string postChunked(const std::string& framing)
+{
+    return "POST /echo HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n" + framing;
+}
+
+/** @brief Splits complete responses off the front of @p in. */
+static std::vector<Response> takeResponses(std::string& in)
+{
+    std::vector<Response> responses;
+    while (true)
+    {
+        usize headEnd = in.find("\r\n\r\n");
+        if (headEnd == std::string::npos)
+            break;
+
+        usize length = 0;
+        usize cl = in.find("Content-Length: ");
+        if (cl != std::string::npos && cl < headEnd)
+            length = std::strtoul(in.c_str() + cl + 16, nullptr, 10);
+
+        if (in.size() < headEnd + 4 + length)
+            break;
+
+        responses.push_back(Response{in.substr(9, 3), in.substr(headEnd + 4, length)});
+        in.erase(0, headEnd + 4 + length);
+    }
+    return responses;
+}
+
+/**
+ * @class Client
+ * @brief Client end of a socketpair served by an epoll Session, one read turn per write
+ *        as the event loop would give it after each EPOLLIN.
+ */
+class Client
+{
+public:
+    explicit Client(WorkerContext& worker)
+    {
+        socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, _fds);
+        _session = std::make_unique<Session>(_fds[0], &worker);
+    }
+
+    ~Client()
+    {
+        _session.reset();
+        ::close(_fds[1]);
+    }
+
+    /** @brief Writes @p data in pieces of @p piece bytes, the session reads after each. */
+    void send(const std::string& data, usize piece = ~usize(0))
+    {
+        for (usize pos = 0; pos < data.size(); pos += piece)
+        {
+            usize len = std::min(piece, data.size() - pos);
+            if (::send(_fds[1], data.data() + pos, len, 0) != static_cast<ssize_t>(len))
+                return;
+            turn();
+        }
+    }
+
+    /** @brief Responses complete so far, after a few more turns for pipelined leftovers. */
+    std::vector<Response> responses()
+    {
+        for (int i = 0; i < 8; ++i)
+            turn();
+
+        std::vector<Response> done = takeResponses(_in);
+        _responses.insert(_responses.end(), done.begin(), done.end());
+        return std::move(_responses);
+    }
+
+    /** @brief Bytes received and not taken as a complete response yet. */
+    const std::string& pending() const noexcept { return _in; }
+
+    bool closed() const noexcept { return _closed; }
+
+private:
+    void turn()
+    {
+        _session->onReadReady();
+        _session->onWriteReady();
+
+        char buf[16 * 1024];
+        ssize_t n;
+        while ((n = recv(_fds[1], buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+            _in.append(buf, n);
+        if (n == 0)
+            _closed = true;
+    }
+
+    int _fds[2] = {-1, -1};
+    std::unique_ptr<Session> _session;
+    std::string _in;
+    std::vector<Response> _responses;
+    bool _closed = false;
+};
+
+static bool splitRequest(WorkerContext& worker)
+{
+    const std::string request = post("hello world");
+
+    for (usize piece : {1, 2, 7, 30})
+    {
+        Client client(worker);
+        client.send(request, piece);
+
+        std::vector<Response> responses = client.responses();
+        CHECK(responses.size() == 1);
+        CHECK(responses[0].status == "200");
+        CHECK(responses[0].body == "/echo:hello world");
+        CHECK(!client.closed());
+    }
+    return true;
+}
+
+static bool pipelinedRequests(WorkerContext& worker)
+{
+    const std::string requests =
+        "GET /hello?a=1 HTTP/1.1\r\nHost: localhost\r\n\r\n" +
+        post("abc") +
+        postChunked(CHUNKED_BODY) +
+        "GET /hello?b=2 HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    // All at once, then cut at every few bytes so boundaries fall between and inside requests
+    for (usize piece : {requests.size(), usize(1), usize(5), usize(64)})
+    {
+        Client client(worker);
+        client.send(requests, piece);
+
+        std::vector<Response> responses = client.responses();
+        CHECK(responses.size() == 4);
+        CHECK(responses[0].body == "hi a=1");
+        CHECK(responses[1].body == "/echo:abc");
+        CHECK(responses[2].body == "/echo:" + DECODED_BODY);
+        CHECK(responses[3].body == "hi b=2");
+        for (const Response& response : responses)
+            CHECK(response.status == "200");
+    }
+    return true;
+}
+
+static bool chunkedAcrossReads(WorkerContext& worker)
+{
+    const std::string request = postChunked(CHUNKED_BODY);
+    const usize bodyStart = request.size() - CHUNKED_BODY.size();
+
+    // The head in one read, then the framing cut at every position
+    for (usize cut = 1; cut < CHUNKED_BODY.size(); ++cut)
+    {
+        Client client(worker);
+        client.send(request.substr(0, bodyStart + cut));
+        client.send(request.substr(bodyStart + cut) + "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n");
+
+        std::vector<Response> responses = client.responses();
+        CHECK(responses.size() == 2);
+        CHECK(responses[0].status == "200");
+        CHECK(responses[0].body == "/echo:" + DECODED_BODY);
+        CHECK(responses[1].body == "hi ");
+    }
+    return true;
+}
+
+static bool malformedChunkSizes(WorkerContext& worker)
+{
+    struct Case {
+        std::string framing;
+        const char* status;
+    };
+
+    const Case cases[] = {
+        {"zz\r\nabc\r\n0\r\n\r\n", "400"},              // Not hex
+        {"\r\nabc\r\n0\r\n\r\n", "400"},                // No digits
+        {"-4\r\nabcd\r\n0\r\n\r\n", "400"},             // Sign
+        {"0x4\r\nabcd\r\n0\r\n\r\n", "400"},            // Prefix
+        {"4x\r\nabcd\r\n0\r\n\r\n", "400"},             // Junk after the digits
+        {"4\nabcd\r\n0\r\n\r\n", "400"},                // Bare LF
+        {"4\r\nabcdef\r\n0\r\n\r\n", "400"},            // Data longer than the size
+        {"ffffffffffffffffffff\r\n", "413"},            // Would wrap around
+        {"10001\r\n", "413"},                           // Over max_body_size
+        {"4" + std::string(MAX_CHUNK_LINE_SIZE + 8, ';'), "400"}, // Size line never ends
+    };
+
+    for (const Case& c : cases)
+    {
+        // Whole, and again one byte at a time
+        for (usize piece : {usize(~0), usize(1)})
+        {
+            Client client(worker);
+            client.send(postChunked(c.framing), piece);
+
+            std::vector<Response> responses = client.responses();
+            CHECK(responses.size() == 1);
+            CHECK(responses[0].status == c.status);
+            CHECK(client.closed());
+        }
+    }
+    return true;
+}
+
+static bool expectContinue(WorkerContext& worker)
+{
+    const std::string head =
+        "POST /echo HTTP/1.1\r\nHost: localhost\r\nExpect: 100-continue\r\nContent-Length: 5\r\n\r\n";
+
+    {
+        Client client(worker);
+        client.send(head);
+
+        // Only the interim response until the body arrives
+        std::vector<Response> responses = client.responses();
+        CHECK(responses.size() == 1);
+        CHECK(responses[0].status == "100");
+        CHECK(client.pending().empty());
+
+        client.send("hello");
+        responses = client.responses();
+        CHECK(responses.size() == 1);
+        CHECK(responses[0].status == "200");
+        CHECK(responses[0].body == "/echo:hello");
+    }
+
+    {
+        // Refused before the client sends the body, no 100 Continue first
+        Client client(worker);
+        client.send("POST /missing HTTP/1.1\r\nHost: localhost\r\nExpect: 100-continue\r\nContent-Length: 5\r\n\r\n");
+
+        std::vector<Response> responses = client.responses();
+        CHECK(responses.size() == 1);
+        CHECK(responses[0].status == "404");
+        CHECK(client.closed());
+    }
+
+    {
+        // HTTP/1.0 knows no interim responses
+        Client client(worker);
+        client.send("POST /echo HTTP/1.0\r\nExpect: 100-continue\r\nContent-Length: 5\r\n\r\nhello");
+
+        std::vector<Response> responses = client.responses();
+        CHECK(responses.size() == 1);
+        CHECK(responses[0].status == "200");
+    }
+    return true;
+}
+
+int main()
+{
+    // As in the server: a session closing on a malformed request is not a reason to die
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (!Settings::updateSettings(ink::EnhancedJson()))
+    {
+        std::fprintf(stderr, "Default settings rejected\n");
+        return 1;
+    }
+
+    registerEndpoints();
+
+    WorkerContext worker;
+    worker.responseHeads.refreshDate(time(nullptr));
+
+    bool ok = true;
+    ok &= splitRequest(worker);
+    ok &= pipelinedRequests(worker);
+    ok &= chunkedAcrossReads(worker);
+    ok &= malformedChunkSizes(worker);
+    ok &= expectContinue(worker);
+
+    if (!ok)
+        return 1;
+
+    std::puts("HttpParserTest passed");
+    return 0;
+}
@@ -0,0 +1,258 @@
+// MpscQueue ordering under concurrent producers, and Mailbox wakeups: coalesced while the
+// worker has not drained yet, signalled again after a drain, never lost, over an eventfd
+// and over an IORING_OP_MSG_RING into the worker's ring.
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <liburing.h>
+
+#include "EventLoop/Mailbox.h"
+#include "EventLoop/WorkerContext.h"
+#include "Utils/MpscQueue.h"
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            return false;                                                   \
+        }                                                                   \
+    } while (0)
+
+/** @brief Signals pending on @p eventFd, consuming them. */
+static u64 takeSignals(int eventFd)
+{
+    u64 count = 0;
+    if (read(eventFd, &count, sizeof(count)) != sizeof(count))
+        return 0;
+    return count;
+}
+
+static bool queueOrder()
+{
+    // Rounded up to 8
+    MpscQueue<int> queue(5);
+    for (int i = 0; i < 8; ++i)
+        CHECK(queue.push(i));
+    CHECK(!queue.push(8));
+
+    int value;
+    for (int i = 0; i < 8; ++i)
+    {
+        CHECK(queue.pop(value));
+        CHECK(value == i);
+    }
+    CHECK(!queue.pop(value));
+    CHECK(queue.empty());
+
+    // Slots are reused once consumed, across the wrap of the sequence numbers
+    for (int round = 0; round < 100; ++round)
+    {
+        CHECK(queue.push(round));
+        CHECK(queue.pop(value) && value == round);
+    }
+    return true;
+}
+
+static bool queueProducers()
+{
+    constexpr int PRODUCERS = 4;
+    constexpr int PER_PRODUCER = 100000;
+
+    MpscQueue<u64> queue(256);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p)
+    {
+        producers.emplace_back([&queue, p] {
+            for (u64 i = 0; i < PER_PRODUCER; )
+            {
+                if (queue.push((u64(p) << 32) | i))
+                    ++i;
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    // Every value arrives exactly once, each producer's in the order it pushed them
+    u64 next[PRODUCERS] = {};
+    u64 received = 0;
+    while (received < u64(PRODUCERS) * PER_PRODUCER)
+    {
+        u64 value;
+        if (!queue.pop(value))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        u64 producer = value >> 32;
+        CHECK(producer < PRODUCERS);
+        CHECK((value & 0xffffffff) == next[producer]);
+        next[producer]++;
+        received++;
+    }
+
+    for (std::thread& producer : producers)
+        producer.join();
+
+    u64 value;
+    CHECK(!queue.pop(value));
+    return true;
+}
+
+static bool eventFdWakeups(WorkerContext& worker)
+{
+    int eventFd = eventfd(0, EFD_NONBLOCK);
+    Mailbox mailbox(4);
+    mailbox.attachEventFd(eventFd);
+
+    int ran = 0;
+    auto task = [&ran](WorkerContext&) { ran++; };
+
+    // Nothing posted: no signal, nothing to drain
+    CHECK(!mailbox.drain(worker, 8));
+    CHECK(takeSignals(eventFd) == 0);
+
+    // Posts before the worker drains share one signal
+    CHECK(mailbox.post(task));
+    CHECK(mailbox.post(task));
+    CHECK(mailbox.post(task));
+    CHECK(takeSignals(eventFd) == 1);
+
+    // A drain stopping at its budget tells the loop to come back before blocking
+    CHECK(mailbox.drain(worker, 2));
+    CHECK(ran == 2);
+    CHECK(!mailbox.drain(worker, 2));
+    CHECK(ran == 3);
+    CHECK(worker.stats.mailboxTasks == 3);
+
+    // Posting after a drain signals again
+    CHECK(mailbox.post(task));
+    CHECK(takeSignals(eventFd) == 1);
+    CHECK(!mailbox.drain(worker, 8));
+    CHECK(ran == 4);
+
+    // Full: refused, nothing dropped of what was queued
+    for (int i = 0; i < 4; ++i)
+        CHECK(mailbox.post(task));
+    CHECK(!mailbox.post(task));
+    CHECK(!mailbox.drain(worker, 8));
+    CHECK(ran == 8);
+
+    close(eventFd);
+    return true;
+}
+
+static bool noLostWakeup(WorkerContext& worker)
+{
+    constexpr int PRODUCERS = 3;
+    constexpr int PER_PRODUCER = 20000;
+
+    int eventFd = eventfd(0, EFD_NONBLOCK);
+    Mailbox mailbox(64);
+    mailbox.attachEventFd(eventFd);
+
+    std::atomic<int> ran{0};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; ++p)
+    {
+        producers.emplace_back([&] {
+            for (int i = 0; i < PER_PRODUCER; )
+            {
+                if (mailbox.post([&ran](WorkerContext&) { ran.fetch_add(1, std::memory_order_relaxed); }))
+                    ++i;
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+
+    // The loop as the workers run it: wait on the eventfd unless the last drain left a backlog.
+    // A lost wakeup leaves tasks queued with no signal, the wait then times out.
+    bool backlog = false;
+    bool lost = false;
+    while (!lost && ran.load(std::memory_order_relaxed) < PRODUCERS * PER_PRODUCER)
+    {
+        if (!backlog)
+        {
+            pollfd pfd{eventFd, POLLIN, 0};
+            lost = poll(&pfd, 1, 5000) != 1;
+            takeSignals(eventFd);
+        }
+        backlog = mailbox.drain(worker, 16);
+    }
+
+    // Producers blocked on a full mailbox finish once it is drained
+    while (ran.load(std::memory_order_relaxed) < PRODUCERS * PER_PRODUCER)
+    {
+        if (!mailbox.drain(worker, 16))
+            std::this_thread::yield();
+    }
+    for (std::thread& producer : producers)
+        producer.join();
+
+    close(eventFd);
+    CHECK(!lost);
+    return true;
+}
+
+static bool ringWakeups(WorkerContext& worker)
+{
+    io_uring ring;
+    if (io_uring_queue_init(8, &ring, 0) < 0)
+    {
+        std::puts("io_uring unavailable, MSG_RING wakeups not tested");
+        return true;
+    }
+
+    Mailbox mailbox(4);
+    mailbox.attachRing(ring.ring_fd);
+
+    int ran = 0;
+    auto task = [&ran](WorkerContext&) { ran++; };
+
+    // Posted from a thread running no loop, so through the lazily created sender ring
+    std::thread([&] {
+        mailbox.post(task);
+        mailbox.post(task);
+    }).join();
+
+    io_uring_cqe* cqe;
+    __kernel_timespec timeout{5, 0};
+    bool ok = io_uring_wait_cqe_timeout(&ring, &cqe, &timeout) == 0 && io_uring_cqe_get_data64(cqe) == MAILBOX_TAG;
+    if (ok)
+        io_uring_cqe_seen(&ring, cqe);
+
+    // One wakeup for both
+    ok = ok && io_uring_peek_cqe(&ring, &cqe) != 0;
+    ok = ok && !mailbox.drain(worker, 8) && ran == 2;
+
+    io_uring_queue_exit(&ring);
+    CHECK(ok);
+    return true;
+}
+
+int main()
+{
+    WorkerContext worker;
+
+    bool ok = true;
+    ok &= queueOrder();
+    ok &= queueProducers();
+    ok &= eventFdWakeups(worker);
+    ok &= noLostWakeup(worker);
+    ok &= ringWakeups(worker);
+
+    if (!ok)
+        return 1;
+
+    std::puts("MailboxTest passed");
+    return 0;
+}
@@ -0,0 +1,186 @@
+// MirrorBuffer reads and writes across the wrap point of its double mapping, write
+// buffers chaining SlabPool segments once the ring is full, and read bytes held for pins.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "Utils/MirrorBuffer.h"
+#include "Utils/SlabPool.h"
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            return false;                                                   \
+        }                                                                   \
+    } while (0)
+
+static std::string pattern(usize len, usize seed)
+{
+    std::string data(len, '\0');
+    for (usize i = 0; i < len; ++i)
+        data[i] = static_cast<char>('a' + (seed + i) % 26);
+    return data;
+}
+
+/** @brief Everything buffered, ring and segments, through peek(). */
+static std::string contents(const MirrorBuffer& buffer)
+{
+    std::string out;
+    usize avail;
+    while (const char* data = buffer.peek(out.size(), avail))
+        out.append(data, avail);
+    return out;
+}
+
+static bool wraparound()
+{
+    MirrorBufferPool pool;
+    const usize page = static_cast<usize>(sysconf(_SC_PAGESIZE));
+    MirrorBuffer buffer(pool, page);
+    CHECK(buffer.isMirrored());
+    CHECK(buffer.capacity() == page);
+
+    // Leave 100 bytes right before the end of the ring
+    CHECK(buffer.write(pattern(page - 100, 0).data(), page - 100) == page - 100);
+    buffer.advanceReadPos(page - 200);
+    CHECK(buffer.size() == 100);
+
+    // All free space is one contiguous run, even though it starts 100 bytes before the wrap
+    usize avail;
+    char* dst = buffer.getWriteBuffer(avail);
+    CHECK(avail == page - 100);
+    std::string written = pattern(300, 7);
+    std::copy(written.begin(), written.end(), dst);
+    buffer.advanceWritePos(written.size());
+
+    // And so are the buffered bytes across it
+    std::string expected = pattern(page - 100, 0).substr(page - 200) + written;
+    const char* data = buffer.getReadBuffer(avail);
+    CHECK(avail == 400);
+    CHECK(std::string(data, avail) == expected);
+
+    for (usize offset : {usize(0), usize(99), usize(100), usize(399)})
+    {
+        const char* at = buffer.peek(offset, avail);
+        CHECK(avail == 400 - offset);
+        CHECK(std::string(at, avail) == expected.substr(offset));
+    }
+    CHECK(buffer.peek(400, avail) == nullptr && avail == 0);
+
+    // Filled up to the last byte across the wrap, then drained: starts over at the front
+    CHECK(buffer.write(pattern(page, 3).data(), page) == page - 400);
+    CHECK(buffer.size() == page);
+    buffer.getWriteBuffer(avail);
+    CHECK(avail == 0);
+
+    buffer.advanceReadPos(page);
+    CHECK(buffer.size() == 0);
+    CHECK(buffer.getWriteBuffer(avail) == buffer.getReadBuffer(avail));
+    return true;
+}
+
+static bool overflowSegments()
+{
+    MirrorBufferPool pool;
+    SlabPool slabs;
+    const usize page = static_cast<usize>(sysconf(_SC_PAGESIZE));
+    const usize limit = 2 * SlabPool::classSize(0);
+    MirrorBuffer buffer(pool, page, &slabs, limit);
+
+    // The ring takes one page, the rest goes to segments
+    std::string first = pattern(page + 5000, 1);
+    CHECK(buffer.write(first.data(), first.size()) == first.size());
+    CHECK(buffer.isSegmented());
+    CHECK(contents(buffer) == first);
+
+    // Once segments are in use everything after them follows, even with ring space back
+    buffer.advanceReadPos(100);
+    std::string second = pattern(50, 2);
+    CHECK(buffer.write(second.data(), second.size()) == second.size());
+    CHECK(contents(buffer) == first.substr(100) + second);
+
+    // The ring drained: reads continue in the first segment
+    buffer.advanceReadPos(page - 100);
+    usize avail;
+    const char* data = buffer.getReadBuffer(avail);
+    CHECK(std::string(data, avail) == first.substr(page, avail));
+
+    // Past the limit the write is cut short and reported
+    std::string big(limit, 'z');
+    usize n = buffer.write(big.data(), big.size());
+    CHECK(n < big.size());
+    CHECK(buffer.truncated());
+
+    buffer.advanceReadPos(buffer.size());
+    CHECK(!buffer.isSegmented());
+    CHECK(slabs.inUse() == 0);
+    return true;
+}
+
+static bool pinnedBytes()
+{
+    MirrorBufferPool pool;
+    const usize page = static_cast<usize>(sysconf(_SC_PAGESIZE));
+    MirrorBuffer buffer(pool, page);
+
+    // A request whose body is still being sent from the buffer after it was consumed
+    const std::string request = pattern(1000, 5);
+    CHECK(buffer.write(request.data(), request.size()) == request.size());
+    usize avail;
+    const char* body = buffer.getReadBuffer(avail) + 200;
+    buffer.pin(body);
+
+    // A second body further ahead shares the first pin
+    buffer.pin(body + 300);
+    buffer.advanceReadPos(request.size());
+    CHECK(buffer.size() == 0);
+    CHECK(buffer.isPinned());
+
+    // Writes only get the space in front of the held bytes, across the wrap
+    buffer.getWriteBuffer(avail);
+    CHECK(avail == page - 800);
+    CHECK(buffer.write(pattern(page, 9).data(), page) == page - 800);
+    CHECK(std::string(body, 800) == request.substr(200));
+
+    buffer.unpin();
+    CHECK(buffer.isPinned());
+    buffer.getWriteBuffer(avail);
+    CHECK(avail == 0);
+
+    // The last pin gone, the bytes are free again
+    buffer.unpin();
+    CHECK(!buffer.isPinned());
+    buffer.getWriteBuffer(avail);
+    CHECK(avail == 800);
+
+    // Pinned bytes not read yet are not counted twice
+    buffer.advanceReadPos(buffer.size());
+    CHECK(buffer.write(request.data(), request.size()) == request.size());
+    buffer.pin(buffer.getReadBuffer(avail) + 600);
+    buffer.advanceReadPos(500);
+    buffer.getWriteBuffer(avail);
+    CHECK(avail == page - 500);
+    buffer.advanceReadPos(500);
+    buffer.getWriteBuffer(avail);
+    CHECK(avail == page - 400);
+    buffer.unpin();
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+    ok &= wraparound();
+    ok &= overflowSegments();
+    ok &= pinnedBytes();
+
+    if (!ok)
+        return 1;
+
+    std::puts("MirrorBufferTest passed");
+    return 0;
+}
@@ -0,0 +1,274 @@
+// Session reads against a one-entry provided buffer ring: once the ring runs dry the
+// session must fall back to its private buffer instead of re-arming buffer-select recvs
+// that keep failing with ENOBUFS. Also covers a partial request moved out of a provided
+// buffer before the buffer is reused, and a cancelled recv whose CQE arrives after reading
+// was already resumed.
+//
+// Needs a kernel with provided buffer rings (5.19), skipped otherwise.
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <ink/ink.hpp>
+
+#include "EventLoop/ProvidedBufferRing.h"
+#include "EventLoop/WorkerContext.h"
+#include "Managers/EndpointManager.h"
+#include "Response/HttpResponse.h"
+#include "Server/Session.h"
+#include "Settings/Settings.h"
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            return false;                                                   \
+        }                                                                   \
+    } while (0)
+
+// Exit code ctest reports as skipped
+#define SKIPPED 77
+
+static const std::string REQUEST = "GET /missing HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+// user_data of the recv the test uses to hold on to the ring's only buffer
+static constexpr u64 HOG_TAG = 1;
+
+struct Completions {
+    u32 enobufs = 0;
+    u32 selected = 0;  // Reads that came in through a provided buffer
+};
+
+// Hands one completion to its session the way the io_uring worker loop does
+// @return false if there was none within 10 ms or the session wants to be closed
+static bool dispatchOne(io_uring& ring, Completions& seen)
+{
+    io_uring_submit(&ring);
+
+    io_uring_cqe* cqe;
+    __kernel_timespec ts = { 0, 10 * 1000 * 1000 };
+    if (io_uring_wait_cqe_timeout(&ring, &cqe, &ts) != 0)
+        return true;
+
+    u64 tag = io_uring_cqe_get_data64(cqe);
+    i32 res = cqe->res;
+    u32 flags = cqe->flags;
+    io_uring_cqe_seen(&ring, cqe);
+
+    if (tag == 0 || tag == HOG_TAG)
+        return true;
+
+    IoRequest* req = reinterpret_cast<IoRequest*>(tag);
+    if (req->optype == OperationType::Read)
+    {
+        if (res == -ENOBUFS) seen.enobufs++;
+        if (flags & IORING_CQE_F_BUFFER) seen.selected++;
+        return req->session->processRead(res, flags, &ring);
+    }
+
+    if (flags & IORING_CQE_F_MORE)
+        req->session->updateIoState(IO_WAITING_ZC, true);
+    return req->session->processWrite(res, (flags & IORING_CQE_F_NOTIF) != 0, &ring);
+}
+
+// Runs completions until @p client has a response
+static bool runUntilResponse(io_uring& ring, int client, std::string& response, Completions& seen)
+{
+    response.clear();
+    for (int round = 0; round < 100; ++round)
+    {
+        char buf[1024];
+        ssize_t n = recv(client, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n > 0)
+        {
+            response.append(buf, n);
+            if (response.find("\r\n\r\n") != std::string::npos)
+                return true;
+        }
+
+        CHECK(dispatchOne(ring, seen));
+    }
+
+    std::fprintf(stderr, "no response after 100 rounds (%u ENOBUFS completions)\n", seen.enobufs);
+    return false;
+}
+
+// Closes the client end and reaps the session's last completions, so none outlives it
+static void hangUp(io_uring& ring, Session& session, int client)
+{
+    ::close(client);
+
+    Completions seen;
+    for (int round = 0; round < 100 && session.hasPendingIo(); ++round)
+        dispatchOne(ring, seen);
+}
+
+static bool fallbackWhileRingIsDry(io_uring& ring, WorkerContext& worker, ProvidedBufferRing& bufRing)
+{
+    // Take the ring's only buffer and keep it
+    int hog[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, hog) == 0);
+    CHECK(send(hog[1], "x", 1, 0) == 1);
+
+    io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+    io_uring_prep_recv(sqe, hog[0], nullptr, 0, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = bufRing.groupId();
+    io_uring_sqe_set_data64(sqe, HOG_TAG);
+    io_uring_submit(&ring);
+
+    io_uring_cqe* cqe;
+    CHECK(io_uring_wait_cqe(&ring, &cqe) == 0);
+    CHECK(cqe->res == 1 && (cqe->flags & IORING_CQE_F_BUFFER));
+    u16 heldBid = static_cast<u16>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+    io_uring_cqe_seen(&ring, cqe);
+
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+    Session session(fds[0], &worker);
+    session.onReadReady(io_uring_get_sqe(&ring));
+
+    // The ring is dry: the recv fails with ENOBUFS and is retried into the private buffer.
+    // The kernel picks the buffer when the recv is issued, so every re-arm while the ring
+    // is dry fails once, data or not, but never more than once per request
+    Completions seen;
+    std::string response;
+    u32 requests = 0;
+    auto roundTrip = [&]() {
+        requests++;
+        return send(fds[1], REQUEST.data(), REQUEST.size(), 0) == static_cast<ssize_t>(REQUEST.size()) &&
+               runUntilResponse(ring, fds[1], response, seen) &&
+               response.compare(0, 12, "HTTP/1.1 404") == 0;
+    };
+
+    for (int i = 0; i < 3; ++i)
+        CHECK(roundTrip());
+    CHECK(seen.enobufs >= 1 && seen.enobufs <= requests);
+    CHECK(seen.selected == 0);
+
+    // With the buffer back, the session returns to the ring once its fallback read is done
+    bufRing.recycle(heldBid);
+    for (int i = 0; i < 2; ++i)
+        CHECK(roundTrip());
+    CHECK(seen.enobufs <= requests);
+    CHECK(seen.selected >= 1);
+
+    hangUp(ring, session, fds[1]);
+    ::close(hog[0]);
+    ::close(hog[1]);
+    return true;
+}
+
+static bool partialRequestRelocated(io_uring& ring, WorkerContext& worker, ProvidedBufferRing& bufRing)
+{
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+    Session session(fds[0], &worker);
+    session.onReadReady(io_uring_get_sqe(&ring));
+
+    // Request line and a header parsed from the provided buffer, then staged into the
+    // session's own buffer once the buffer goes back to the ring
+    const std::string head = "POST /echo?k=v HTTP/1.1\r\nX-Tag: relocated\r\nHost: loc";
+    const std::string rest = "alhost\r\nContent-Length: 5\r\n\r\nhello";
+
+    Completions seen;
+    CHECK(send(fds[1], head.data(), head.size(), 0) == static_cast<ssize_t>(head.size()));
+    for (int round = 0; round < 100 && seen.selected == 0; ++round)
+        CHECK(dispatchOne(ring, seen));
+    CHECK(seen.selected == 1);
+
+    // Whatever the ring hands out next lands where the views parsed so far pointed
+    std::memset(bufRing.buffer(0), 'z', 4096);
+
+    std::string response;
+    CHECK(send(fds[1], rest.data(), rest.size(), 0) == static_cast<ssize_t>(rest.size()));
+    CHECK(runUntilResponse(ring, fds[1], response, seen));
+    CHECK(response.compare(0, 12, "HTTP/1.1 200") == 0);
+    CHECK(response.find("\r\n\r\n/echo?k=v relocated:hello") != std::string::npos);
+
+    hangUp(ring, session, fds[1]);
+    return true;
+}
+
+static bool cancelledAfterResume(io_uring& ring, WorkerContext& worker)
+{
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+    Session session(fds[0], &worker);
+
+    // resumeRead() ran while the cancelled recv was in flight and left the re-arm to its CQE
+    CHECK(!session.isReadInFlight());
+    CHECK(session.processRead(-ECANCELED, 0, &ring));
+    CHECK(session.isReadInFlight());
+
+    Completions seen;
+    std::string response;
+    CHECK(send(fds[1], REQUEST.data(), REQUEST.size(), 0) == static_cast<ssize_t>(REQUEST.size()));
+    CHECK(runUntilResponse(ring, fds[1], response, seen));
+    CHECK(response.compare(0, 12, "HTTP/1.1 404") == 0);
+
+    hangUp(ring, session, fds[1]);
+    return true;
+}
+
+int main()
+{
+    if (!Settings::updateSettings(ink::EnhancedJson()))
+    {
+        std::fprintf(stderr, "Default settings rejected\n");
+        return 1;
+    }
+
+    Endpoint* echo = new Endpoint("/echo", Method::POST);
+    echo->setHandlerCallback([](const HttpRequest& request, HttpResponse& response) {
+        response.setBody(std::string(request.path()) + "?" + std::string(request.query()) + " " +
+                         std::string(request.getHeader("X-Tag")) + ":" + std::string(request.body()));
+    });
+    EndpointManager::getInstance()->registerEndpoint(echo);
+
+    io_uring ring = {};
+    if (io_uring_queue_init(64, &ring, 0) < 0)
+    {
+        std::puts("io_uring unavailable, ProvidedBufferRingTest skipped");
+        return SKIPPED;
+    }
+
+    int result = SKIPPED;
+    {
+        ProvidedBufferRing bufRing(&ring, 0, 1, 4096);
+        if (bufRing.isValid())
+        {
+            WorkerContext worker;
+            worker.backend = IoBackend::IoUring;
+            worker.ring = &ring;
+            worker.ringFd = ring.ring_fd;
+            worker.bufRing = &bufRing;
+
+            bool ok = fallbackWhileRingIsDry(ring, worker, bufRing);
+            ok &= partialRequestRelocated(ring, worker, bufRing);
+
+            // Without the buffer ring, reads go to the session's own buffer
+            WorkerContext plainWorker;
+            plainWorker.backend = IoBackend::IoUring;
+            plainWorker.ring = &ring;
+            plainWorker.ringFd = ring.ring_fd;
+            ok &= cancelledAfterResume(ring, plainWorker);
+
+            result = ok ? 0 : 1;
+        }
+        else
+        {
+            std::puts("Provided buffer rings unsupported, ProvidedBufferRingTest skipped");
+        }
+    }
+
+    io_uring_queue_exit(&ring);
+
+    if (result == 0)
+        std::puts("ProvidedBufferRingTest passed");
+    return result;
+}
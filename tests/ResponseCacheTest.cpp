@@ -0,0 +1,174 @@
+// ResponseCache keys, replay with a fresh Date, TTL expiry and eviction within a route's budget.
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+
+#include "Endpoint/Endpoint.h"
+#include "Response/HttpResponse.h"
+#include "Response/ResponseCache.h"
+#include "Utils/BumpArena.h"
+#include "Utils/MirrorBuffer.h"
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            return false;                                                   \
+        }                                                                   \
+    } while (0)
+
+static constexpr u32 TTL_MS = 1000;
+
+static const std::string DATE_1 = "Sun, 06 Nov 1994 08:49:37 GMT";
+static const std::string DATE_2 = "Mon, 07 Nov 1994 09:50:38 GMT";
+
+static std::string response(const std::string& date, const std::string& body)
+{
+    return "HTTP/1.1 200 OK\r\nDate: " + date + "\r\nContent-Length: " + std::to_string(body.size()) +
+           "\r\n\r\n" + body;
+}
+
+static std::string contents(const MirrorBuffer& buffer)
+{
+    std::string out;
+    usize avail;
+    while (const char* data = buffer.peek(out.size(), avail))
+        out.append(data, avail);
+    return out;
+}
+
+/** @brief Stores @p bytes for @p key the way the session does, behind what the buffer already holds. */
+static void store(ResponseCache& cache, const Endpoint& endpoint, const std::string& key, u64 nowMs,
+                  const std::string& bytes)
+{
+    MirrorBufferPool pool;
+    MirrorBuffer out(pool, 64 * 1024);
+    HttpResponse::writeAll(out, "earlier response", 16);
+    HttpResponse::writeAll(out, bytes.data(), bytes.size());
+    cache.store(endpoint, key, nowMs, out, 16);
+}
+
+/** @brief The replayed bytes, empty on a miss. */
+static std::string serve(ResponseCache& cache, const Endpoint& endpoint, const std::string& key, u64 nowMs,
+                         const std::string& date = DATE_2)
+{
+    MirrorBufferPool pool;
+    MirrorBuffer out(pool, 64 * 1024);
+    if (!cache.serve(endpoint, key, nowMs, date, out))
+        return {};
+    return contents(out);
+}
+
+static ResponseCache::RouteStats stats(const ResponseCache& cache, const Endpoint& endpoint)
+{
+    ResponseCache::RouteStats found;
+    cache.forEachRoute([&](const Endpoint& e, const ResponseCache::RouteStats& s) {
+        if (&e == &endpoint)
+            found = s;
+    });
+    return found;
+}
+
+static bool keys()
+{
+    BumpArena arena(4096);
+    CHECK(ResponseCache::makeKey("/items", "", arena) == "/items");
+    CHECK(ResponseCache::makeKey("/items", "b=2&a=1", arena) == "/items?a=1&b=2");
+    CHECK(ResponseCache::makeKey("/items", "a=1&&b=2&", arena) == "/items?a=1&b=2");
+    CHECK(ResponseCache::makeKey("/items", "a=2&a=1", arena) == "/items?a=1&a=2");
+    return true;
+}
+
+static bool replayWithFreshDate()
+{
+    Endpoint endpoint("/version", Method::GET);
+    endpoint.setResponseCache(TTL_MS, 64 * 1024);
+    ResponseCache cache;
+
+    CHECK(serve(cache, endpoint, "/version", 0).empty());
+    store(cache, endpoint, "/version", 0, response(DATE_1, "v1"));
+
+    CHECK(serve(cache, endpoint, "/version", 10) == response(DATE_2, "v1"));
+    CHECK(serve(cache, endpoint, "/version?x=1", 10).empty());
+
+    // Without a Date header the bytes are replayed as stored
+    const std::string plain = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nv2";
+    store(cache, endpoint, "/plain", 0, plain);
+    CHECK(serve(cache, endpoint, "/plain", 10) == plain);
+
+    ResponseCache::RouteStats s = stats(cache, endpoint);
+    CHECK(s.hits == 2);
+    CHECK(s.misses == 2);
+    CHECK(s.entries == 2);
+    return true;
+}
+
+static bool expiry()
+{
+    Endpoint endpoint("/version", Method::GET);
+    endpoint.setResponseCache(TTL_MS, 64 * 1024);
+    ResponseCache cache;
+
+    store(cache, endpoint, "/version", 1000, response(DATE_1, "v1"));
+    CHECK(!serve(cache, endpoint, "/version", 1000 + TTL_MS - 1).empty());
+
+    // Expired entries are dropped on the miss, the handler refills them
+    CHECK(serve(cache, endpoint, "/version", 1000 + TTL_MS).empty());
+    CHECK(stats(cache, endpoint).entries == 0);
+    CHECK(stats(cache, endpoint).bytes == 0);
+
+    store(cache, endpoint, "/version", 1000 + TTL_MS, response(DATE_1, "v2"));
+    CHECK(serve(cache, endpoint, "/version", 1000 + TTL_MS + 1) == response(DATE_2, "v2"));
+    return true;
+}
+
+static bool eviction()
+{
+    const std::string body(200, 'b');
+    const usize entrySize = std::string("/k0").size() + response(DATE_1, body).size();
+
+    // Room for two entries
+    Endpoint endpoint("/k", Method::GET);
+    endpoint.setResponseCache(TTL_MS, 2 * entrySize + entrySize / 2);
+    ResponseCache cache;
+
+    store(cache, endpoint, "/k0", 0, response(DATE_1, body));
+    store(cache, endpoint, "/k1", 10, response(DATE_1, body));
+    store(cache, endpoint, "/k2", 20, response(DATE_1, body));
+
+    // The one expiring soonest made room
+    CHECK(stats(cache, endpoint).entries == 2);
+    CHECK(stats(cache, endpoint).bytes == 2 * entrySize);
+    CHECK(serve(cache, endpoint, "/k0", 30).empty());
+    CHECK(!serve(cache, endpoint, "/k1", 30).empty());
+    CHECK(!serve(cache, endpoint, "/k2", 30).empty());
+
+    // Expired entries make room before anything live is evicted
+    store(cache, endpoint, "/k3", 10 + TTL_MS, response(DATE_1, body));
+    CHECK(serve(cache, endpoint, "/k1", 10 + TTL_MS).empty());
+    CHECK(!serve(cache, endpoint, "/k2", 10 + TTL_MS).empty());
+    CHECK(!serve(cache, endpoint, "/k3", 10 + TTL_MS).empty());
+
+    // Larger than the whole budget: not cached at all, nothing evicted for it
+    store(cache, endpoint, "/huge", 30, response(DATE_1, std::string(3 * entrySize, 'h')));
+    CHECK(serve(cache, endpoint, "/huge", 31).empty());
+    CHECK(stats(cache, endpoint).entries == 2);
+    return true;
+}
+
+int main()
+{
+    bool ok = true;
+    ok &= keys();
+    ok &= replayWithFreshDate();
+    ok &= expiry();
+    ok &= eviction();
+
+    if (!ok)
+        return 1;
+
+    std::puts("ResponseCacheTest passed");
+    return 0;
+}
@@ -0,0 +1,231 @@
+// Streamed responses through a real epoll Session on a socketpair: chunked framing for
+// HTTP/1.1, an unframed body ending with the connection for HTTP/1.0, and a continuation
+// producing more than the write buffer holds while a pipelined request waits behind it.
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <string>
+
+#include <ink/ink.hpp>
+
+#include "EventLoop/WorkerContext.h"
+#include "Managers/EndpointManager.h"
+#include "Response/HttpResponse.h"
+#include "Server/Session.h"
+#include "Settings/Settings.h"
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            return false;                                                   \
+        }                                                                   \
+    } while (0)
+
+// Pieces /large writes, each of LARGE_PIECE bytes of the same letter
+static constexpr int LARGE_PIECES = 64;
+static constexpr usize LARGE_PIECE = 8 * 1024;
+
+static void registerEndpoints()
+{
+    // "hello" from the handler, then "x" twice from the continuation
+    Endpoint* small = new Endpoint("/stream", Method::GET);
+    small->setHandlerCallback([](const HttpRequest&, HttpResponse& response) {
+        ResponseWriter& stream = response.stream();
+        stream.write("hello");
+        stream.write("");
+
+        auto left = std::make_shared<int>(2);
+        stream.onWritable([left](ResponseWriter& w) {
+            w.write("x");
+            return --*left > 0;
+        });
+    });
+    EndpointManager::getInstance()->registerEndpoint(small);
+
+    // Several times max_response_size, only produced as the client drains it
+    Endpoint* large = new Endpoint("/large", Method::GET);
+    large->setHandlerCallback([](const HttpRequest&, HttpResponse& response) {
+        auto piece = std::make_shared<int>(0);
+        response.stream().onWritable([piece](ResponseWriter& w) {
+            w.write(std::string(LARGE_PIECE, static_cast<char>('a' + *piece % 26)));
+            return ++*piece < LARGE_PIECES;
+        });
+    });
+    EndpointManager::getInstance()->registerEndpoint(large);
+}
+
+static bool endsWith(const std::string& str, const std::string& suffix)
+{
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * @brief Decodes the chunked body starting at @p pos.
+ * @return Offset past the terminating chunk, 0 while it is incomplete.
+ */
+static usize dechunk(const std::string& in, usize pos, std::string& body)
+{
+    while (true)
+    {
+        usize lineEnd = in.find("\r\n", pos);
+        if (lineEnd == std::string::npos)
+            return 0;
+
+        usize size = std::strtoul(in.c_str() + pos, nullptr, 16);
+        if (in.size() < lineEnd + 2 + size + 2)
+            return 0;
+
+        body.append(in, lineEnd + 2, size);
+        pos = lineEnd + 2 + size + 2;
+        if (size == 0)
+            return pos;
+    }
+}
+
+/**
+ * @brief Runs the session's epoll handlers and reads what it sent until @p done or the
+ *        session closed the connection.
+ * @param closed Set when the client saw the end of the stream.
+ */
+template <typename Done>
+static void exchange(Session& session, int client, std::string& response, bool& closed, Done done)
+{
+    closed = false;
+    for (int round = 0; round < 10000 && !done(response); ++round)
+    {
+        session.onReadReady();
+        session.onWriteReady();
+
+        char buf[16 * 1024];
+        ssize_t n;
+        while ((n = recv(client, buf, sizeof(buf), MSG_DONTWAIT)) > 0)
+            response.append(buf, n);
+
+        if (n == 0)
+        {
+            closed = true;
+            return;
+        }
+    }
+}
+
+static bool sendAll(int fd, const std::string& data)
+{
+    return send(fd, data.data(), data.size(), 0) == static_cast<ssize_t>(data.size());
+}
+
+static bool chunkedStream(WorkerContext& worker)
+{
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+    Session session(fds[0], &worker);
+
+    CHECK(sendAll(fds[1], "GET /stream HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+
+    std::string response;
+    bool closed;
+    exchange(session, fds[1], response, closed, [](const std::string& r) { return endsWith(r, "0\r\n\r\n"); });
+
+    CHECK(!closed);
+    CHECK(response.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+    CHECK(response.find("Connection: keep-alive\r\n") != std::string::npos);
+    CHECK(response.find("Content-Length") == std::string::npos);
+    CHECK(endsWith(response, "Transfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n1\r\nx\r\n1\r\nx\r\n0\r\n\r\n"));
+
+    ::close(fds[1]);
+    return true;
+}
+
+static bool http10Stream(WorkerContext& worker)
+{
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+    Session session(fds[0], &worker);
+
+    CHECK(sendAll(fds[1], "GET /stream HTTP/1.0\r\n\r\n"));
+
+    std::string response;
+    bool closed;
+    exchange(session, fds[1], response, closed, [](const std::string&) { return false; });
+
+    // The connection delimits the body: no chunk framing, no terminator, never kept alive
+    CHECK(closed);
+    CHECK(response.find("Transfer-Encoding") == std::string::npos);
+    CHECK(response.find("Content-Length") == std::string::npos);
+    CHECK(response.find("keep-alive") == std::string::npos);
+    CHECK(response.find("Connection: close\r\n") != std::string::npos);
+    CHECK(endsWith(response, "\r\n\r\nhelloxx"));
+
+    ::close(fds[1]);
+    return true;
+}
+
+static bool largeStreamBeforePipelined(WorkerContext& worker)
+{
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+    Session session(fds[0], &worker);
+
+    // Both requests arrive together, the second is answered once the first body ended
+    CHECK(sendAll(fds[1], "GET /large HTTP/1.1\r\nHost: localhost\r\n\r\n"
+                          "GET /stream HTTP/1.1\r\nHost: localhost\r\n\r\n"));
+
+    std::string response;
+    bool closed;
+    exchange(session, fds[1], response, closed, [](const std::string& r) {
+        usize head = r.find("\r\n\r\n");
+        std::string body;
+        usize end = head == std::string::npos ? 0 : dechunk(r, head + 4, body);
+        return end > 0 && endsWith(r, "0\r\n\r\n") && r.size() > end;
+    });
+    CHECK(!closed);
+
+    usize head = response.find("\r\n\r\n");
+    CHECK(head != std::string::npos);
+    CHECK(response.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+
+    std::string body;
+    usize end = dechunk(response, head + 4, body);
+    CHECK(end > 0);
+    CHECK(body.size() == LARGE_PIECES * LARGE_PIECE);
+    for (int i = 0; i < LARGE_PIECES; ++i)
+        CHECK(body.find_first_not_of(static_cast<char>('a' + i % 26), i * LARGE_PIECE) >= (i + 1) * LARGE_PIECE);
+
+    std::string next = response.substr(end);
+    CHECK(next.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+    CHECK(endsWith(next, "5\r\nhello\r\n1\r\nx\r\n1\r\nx\r\n0\r\n\r\n"));
+
+    ::close(fds[1]);
+    return true;
+}
+
+int main()
+{
+    if (!Settings::updateSettings(ink::EnhancedJson()))
+    {
+        std::fprintf(stderr, "Default settings rejected\n");
+        return 1;
+    }
+
+    registerEndpoints();
+
+    WorkerContext worker;
+    worker.responseHeads.refreshDate(time(nullptr));
+
+    bool ok = true;
+    ok &= chunkedStream(worker);
+    ok &= http10Stream(worker);
+    ok &= largeStreamBeforePipelined(worker);
+
+    if (!ok)
+        return 1;
+
+    std::puts("ResponseWriterTest passed");
+    return 0;
+}